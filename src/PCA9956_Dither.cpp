@@ -0,0 +1,196 @@
+/**
+ * @file PCA9956_Dither.cpp
+ * @author マゼピン
+ * @brief 時間方向のディザで8bitより細かい明るさを出す
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "Arduino.h"
+#include "PCA9956_Dither.h"
+
+/// @brief 		コンストラクタ
+/// @param drv 	出力先のドライバー(start済みのもの)
+PCA9956_Dither::PCA9956_Dither(PCA9956_LEDDrv *drv)
+{
+	_drv = drv;
+}
+
+/// @brief デストラクタ
+PCA9956_Dither::~PCA9956_Dither()
+{
+}
+
+/// @brief 			16bitで明るさを指定
+/// @param ledno 	LED番号
+/// @param value 	明るさ(0-65535、上位8bitがPWMの値)
+void PCA9956_Dither::set16(uint8_t ledno, uint16_t value)
+{
+	if(ledno < LED_CNT){
+		_value[ledno] = value;
+	}
+}
+
+/// @brief 			12bitで明るさを指定
+/// @param ledno 	LED番号
+/// @param value 	明るさ(0-4095、超えた分は4095にする)
+void PCA9956_Dither::set12(uint8_t ledno, uint16_t value)
+{
+	if(value > 4095){
+		value = 4095;		//そのままシフトすると上位が落ちて暗くなる
+	}
+	set16(ledno, (uint16_t)((value << 4) | (value >> 8)));	//4095が65535になるように下位を埋める
+}
+
+/// @brief 			送信範囲に合わせて更新を見送るかどうか
+/// @param enable 	trueなら見送る(デフォルト)
+/// @details 		ディザで1LSBだけ変わるLEDは、そのフレームで他の理由で送る範囲の外なら誤差として次に回す<br />
+///					誤差が @ref DITHER_HOLD_LIMIT を超えたら範囲外でも送るので、ずれは最大2LSB分
+void PCA9956_Dither::set_bus_aware(bool enable)
+{
+	_bus_aware = enable;
+}
+
+/// @brief 			IREFを下げて低輝度側の範囲を広げるかどうか
+/// @param enable 	trueなら広げる
+/// @return 		OK/NG(startで設定した電流が小さすぎて1/16にできない、または戻す時の送信失敗)
+/// @details 		暗いLEDだけIREFを1/16にして、その分PWMを大きくする<br />
+///					IREFの切り替えは明るさの範囲を跨いだ時だけ送る
+E_RESULT_9956 PCA9956_Dither::set_iref_boost(bool enable)
+{
+	uint8_t base = _drv->iref_base();
+
+	if(!enable){
+		//PWMを通常側の値に戻して送ってからIREFを上げる(逆だと一瞬IREFの倍率分明るくなる)
+		uint8_t *pwm = _drv->pwm_shadow();
+		for(int i = 0; i < LED_CNT; i++){
+			if(_low_mask & (1UL << i)){
+				pwm[i] = _value[i] >> 8;
+				_drv->mark_dirty((uint8_t)i, 1);
+				_err[i] = 0;
+			}
+		}
+		E_RESULT_9956 ret = _drv->flush();
+		if(_drv->led_iref_mask(_low_mask, base) != E_RESULT_9956::OK){
+			ret = E_RESULT_9956::NG;
+		}
+		_low_mask = 0;
+		_boost = false;
+		return ret;
+	}
+
+	_iref_low = base / DITHER_IREF_DIV;
+	if(_iref_low == 0){
+		return E_RESULT_9956::NG;
+	}
+	//IREFは整数なので、倍率は実際の比率で求めておく(tick中は割り算しない)
+	_boost_mul = (uint16_t)(((uint32_t)base << 8) / _iref_low);
+	_boost_leave = (uint16_t)(((uint32_t)0xFFFF << 8) / _boost_mul);
+	_boost_enter = _boost_leave / 4 * 3;	//行ったり来たりしないように間を空ける
+	_boost = true;
+
+	return E_RESULT_9956::OK;
+}
+
+/// @brief 			IREFの範囲を切り替えて、PWMに掛ける明るさを求める
+/// @param ledno 	LED番号
+/// @return 		明るさ(16bit、上位8bitがPWMの値)
+/// @details 		IREFはここでは送らない。tick()で低輝度側に入るLEDはPWMを送る前に下げて、<br />
+///					通常側に戻すLEDはPWMを送った後に上げる(どちらも一瞬明るくなることはない)
+uint32_t PCA9956_Dither::scaled(uint8_t ledno)
+{
+	uint32_t v = _value[ledno];
+	uint32_t bit = 1UL << ledno;
+
+	if(!_boost){
+		return v;
+	}
+	if(!(_low_mask & bit) && v < _boost_enter){
+		_low_mask |= bit;
+		_enter_mask |= bit;
+		_err[ledno] = 0;
+	}else if((_low_mask & bit) && v >= _boost_leave){
+		_low_mask &= ~bit;
+		_err[ledno] = 0;
+		return v;
+	}
+	if(_low_mask & bit){
+		v = (v * _boost_mul) >> 8;
+	}
+
+	return v;
+}
+
+/// @brief 		1フレーム分のディザを計算して送信する
+/// @return 	OK/NG
+/// @details 	1回目で誤差が大きいLEDを確定して、その送信範囲に入る残りのLEDを2回目で決める<br />
+///				送信はシャドウバッファのflush1回だけなので、範囲内のLEDはバイト数が増えない<br />
+///				IREFの切り替えも、下げる物と上げる物をそれぞれ連続した範囲毎に1回で送る
+E_RESULT_9956 PCA9956_Dither::tick()
+{
+	uint8_t *pwm = _drv->pwm_shadow();
+	int32_t acc[LED_CNT];
+	uint8_t want[LED_CNT];
+	uint32_t pending = 0;
+	uint32_t leave = _low_mask;
+
+	_enter_mask = 0;
+	for(int i = 0; i < LED_CNT; i++){
+		acc[i] = _err[i] + (int32_t)scaled((uint8_t)i);
+		int32_t out = acc[i] >> 8;
+		if(out > LED_PWM_MAX){
+			out = LED_PWM_MAX;
+		}else if(out < 0){
+			out = 0;	//見送った分で誤差がマイナスになっている
+		}
+		want[i] = (uint8_t)out;
+
+		int32_t hold = acc[i] - pwm[i] * 256;	//今の値のままにした時の誤差
+		if(want[i] == pwm[i]){
+			continue;
+		}
+		if(!_bus_aware || hold >= DITHER_HOLD_LIMIT || hold <= -DITHER_HOLD_LIMIT){
+			pwm[i] = want[i];
+			_drv->mark_dirty((uint8_t)i, 1);
+		}else{
+			pending |= 1UL << i;
+		}
+	}
+
+	uint8_t lo, hi;
+	if(_drv->dirty_range(lo, hi)){
+		for(int i = lo; i < hi; i++){
+			if(pending & (1UL << i)){
+				pwm[i] = want[i];	//どうせ送る範囲なのでついでに更新する
+			}
+		}
+	}
+
+	for(int i = 0; i < LED_CNT; i++){
+		int32_t err = acc[i] - pwm[i] * 256;
+		if(err > DITHER_HOLD_LIMIT){
+			err = DITHER_HOLD_LIMIT;		//PWMが最大の時に誤差が溜まり続けないようにする
+		}else if(err < -DITHER_HOLD_LIMIT){
+			err = -DITHER_HOLD_LIMIT;
+		}
+		_err[i] = (int16_t)err;
+	}
+
+	E_RESULT_9956 ret = E_RESULT_9956::OK;
+	if(_drv->led_iref_mask(_enter_mask, _iref_low) != E_RESULT_9956::OK){
+		ret = E_RESULT_9956::NG;
+	}
+	if(_drv->flush() != E_RESULT_9956::OK){
+		ret = E_RESULT_9956::NG;
+	}
+	leave &= ~_low_mask;	//このフレームで通常側に戻ったLED
+	if(_drv->led_iref_mask(leave, _drv->iref_base()) != E_RESULT_9956::OK){
+		ret = E_RESULT_9956::NG;
+	}
+
+	return ret;
+}
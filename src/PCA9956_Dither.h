@@ -0,0 +1,60 @@
+/**
+ * @file PCA9956_Dither.h
+ * @author マゼピン
+ * @brief 時間方向のディザで8bitより細かい明るさを出す
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) マゼピン	2023
+ * @addtogroup pca9956
+ * @{
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "PCA9956_LEDDrv.h"
+
+#pragma region 定数
+
+#define DITHER_HOLD_LIMIT 	512		//!<	送信を見送れる誤差の上限(1/256LSB単位、2LSB分)
+#define DITHER_IREF_DIV 	16		//!<	低輝度側のIREFは通常の1/16にする
+
+#pragma endregion
+
+/**
+ * @brief 時間方向のディザを掛けるクラス
+ * @details 12bit/16bitで指定した明るさの小数部分を、毎フレームの誤差の積算(1次のΣΔ)で8bitのPWMに振り分ける<br />
+ *			tick()を一定周期(100Hz以上推奨)で呼ぶこと
+ */
+class PCA9956_Dither
+{
+private:
+#pragma region	プライベート
+	PCA9956_LEDDrv *_drv;				//!<	出力先のドライバー
+	uint16_t _value[LED_CNT] = {0};		//!<	16bitの明るさ
+	int16_t _err[LED_CNT] = {0};		//!<	これまでに出し損ねた明るさ(1/256LSB単位)
+	bool _bus_aware = true;				//!<	trueなら送信範囲外のLEDの更新を見送る
+	uint32_t _low_mask = 0;				//!<	IREFを下げているLEDのビット
+	uint32_t _enter_mask = 0;			//!<	このフレームで低輝度側に入ったLEDのビット(PWMを送る前にIREFを下げる)
+	bool _boost = false;				//!<	IREFで低輝度側の範囲を広げるならtrue
+	uint8_t _iref_low = 0;				//!<	低輝度側のIREF
+	uint16_t _boost_mul = 0;			//!<	低輝度側のPWMの倍率(8bit固定小数点)
+	uint16_t _boost_enter = 0;			//!<	この値より暗くなったら低輝度側に切り替える
+	uint16_t _boost_leave = 0;			//!<	この値以上明るくなったら通常側に戻す
+
+	uint32_t scaled(uint8_t ledno);		//!<	IREFの範囲を切り替えて、PWMに掛ける明るさを求める
+#pragma endregion
+public:
+	PCA9956_Dither(PCA9956_LEDDrv *drv);
+	~PCA9956_Dither();
+
+	void set16(uint8_t ledno, uint16_t value);			//!<	16bitで明るさを指定
+	void set12(uint8_t ledno, uint16_t value);			//!<	12bitで明るさを指定
+	void set_bus_aware(bool enable);					//!<	送信範囲に合わせて更新を見送るかどうか
+	E_RESULT_9956 set_iref_boost(bool enable);			//!<	IREFを下げて低輝度側の範囲を広げるかどうか
+	E_RESULT_9956 tick();								//!<	1フレーム分のディザを計算して送信する
+};
+
+//!	@}
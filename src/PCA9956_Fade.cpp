@@ -0,0 +1,214 @@
+/**
+ * @file PCA9956_Fade.cpp
+ * @author マゼピン
+ * @brief 複数チップのLEDをまとめてフェードさせる
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "Arduino.h"
+#include "PCA9956_Fade.h"
+
+uint16_t PCA9956_Fade::_curve[(int)E_FADE_CURVE::CURVE_CNT][FADE_CURVE_STEPS + 1];
+
+/// @brief 			コンストラクタ
+/// @param chip_max 登録できるチップ数(チップ数 × LED_CNT 分のフェードをここで確保する)
+PCA9956_Fade::PCA9956_Fade(uint8_t chip_max)
+{
+	_chip_max = chip_max;
+	_drv = new PCA9956_LEDDrv *[chip_max];
+	_slot = new T_FadeSlot[chip_max * LED_CNT];
+	_active = new uint16_t[chip_max * LED_CNT];
+
+	for(int i = 0; i < chip_max * LED_CNT; i++){
+		_slot[i].chip = i / LED_CNT;		//tick中に割り算しないように持っておく
+		_slot[i].ledno = i % LED_CNT;
+		_slot[i].active_pos = FADE_INACTIVE;
+	}
+	make_curve();
+}
+
+/// @brief デストラクタ
+PCA9956_Fade::~PCA9956_Fade()
+{
+	delete[] _drv;
+	delete[] _slot;
+	delete[] _active;
+}
+
+/// @brief 		イージングカーブの表を作る
+/// @details 	t(0-256)に対する進み具合を0-65535で持つ(全インスタンスで共通、整数だけで計算する)
+void PCA9956_Fade::make_curve()
+{
+	for(uint32_t t = 0; t <= FADE_CURVE_STEPS; t++){
+		uint32_t u = FADE_CURVE_STEPS - t;
+		uint32_t sq = t * t;									//t^2 (0-65536)
+		uint32_t smooth = (3 * 256 - 2 * t) * t * t / 256;		//3t^2 - 2t^3 (0-65536)
+
+		_curve[(int)E_FADE_CURVE::LINEAR][t] = (uint16_t)(t * 256 - (t >> 8));	//256で65535になるように丸める
+		_curve[(int)E_FADE_CURVE::EASE_IN][t] = (uint16_t)(sq - (sq >> 16));
+		_curve[(int)E_FADE_CURVE::EASE_OUT][t] = (uint16_t)(65535 - u * u + (u * u >> 16));
+		_curve[(int)E_FADE_CURVE::EASE_IN_OUT][t] = (uint16_t)(smooth - (smooth >> 16));
+	}
+}
+
+/// @brief 		ドライバーを登録する
+/// @param drv 	ドライバーオブジェクト(登録した順番がチップ番号になる)
+/// @return 	OK/NG(登録数オーバー)
+E_RESULT_9956 PCA9956_Fade::add_driver(PCA9956_LEDDrv *drv)
+{
+	if(_chip_cnt >= _chip_max){
+		return E_RESULT_9956::NG;
+	}
+	_drv[_chip_cnt++] = drv;
+
+	return E_RESULT_9956::OK;
+}
+
+/// @brief 			動作中リストから外す
+/// @param slotno 	スロット番号
+/// @details 		最後の要素を空いた所に移すので順番は変わる
+void PCA9956_Fade::remove(uint16_t slotno)
+{
+	uint16_t pos = _slot[slotno].active_pos;
+	uint16_t last = _active[--_active_cnt];
+
+	_active[pos] = last;
+	_slot[last].active_pos = pos;
+	_slot[slotno].active_pos = FADE_INACTIVE;
+}
+
+/// @brief 			フェードを登録する
+/// @param chip 	チップ番号
+/// @param ledmask 	対象のLED(bit0がLED0)
+/// @param target 	目標の明るさ
+/// @param ticks 	目標に届くまでのtick数(0ならすぐに目標の明るさにする、ちょうどこのtick数で目標に届く)
+/// @param curve 	イージングカーブ
+/// @return 		OK/NG(チップ番号が範囲外)
+/// @details 		開始値はその時点のシャドウバッファの値<br />
+///					フェード中のLEDに登録した場合は、その時点の明るさから新しいフェードを始める
+E_RESULT_9956 PCA9956_Fade::submit(uint8_t chip, uint32_t ledmask, uint8_t target, uint32_t ticks, E_FADE_CURVE curve)
+{
+	if(chip >= _chip_cnt || curve >= E_FADE_CURVE::CURVE_CNT){
+		return E_RESULT_9956::NG;
+	}
+
+	PCA9956_LEDDrv *drv = _drv[chip];
+	uint8_t *pwm = drv->pwm_shadow();
+	uint32_t step = 0;
+	uint32_t rem = 0;
+	if(ticks > 0){
+		step = FADE_PHASE_ONE / ticks;		//割り算はここだけ(余りはtick毎に積算して、ちょうどticksで終わらせる)
+		rem = FADE_PHASE_ONE % ticks;
+	}
+
+	for(int i = 0; i < LED_CNT; i++){
+		if(!(ledmask & (1UL << i))){
+			continue;
+		}
+		uint16_t slotno = chip * LED_CNT + i;
+		T_FadeSlot &slot = _slot[slotno];
+
+		if(ticks == 0){
+			if(slot.active_pos != FADE_INACTIVE){
+				remove(slotno);
+			}
+			if(pwm[i] != target){
+				pwm[i] = target;
+				drv->mark_dirty((uint8_t)i, 1);
+			}
+			continue;
+		}
+
+		slot.phase = 0;
+		slot.step = step;
+		slot.rem = rem;
+		slot.ticks = ticks;
+		slot.acc = 0;
+		slot.from = pwm[i];
+		slot.delta = (int16_t)target - pwm[i];
+		slot.curve = curve;
+		if(slot.active_pos == FADE_INACTIVE){
+			slot.active_pos = _active_cnt;
+			_active[_active_cnt++] = slotno;
+		}
+	}
+
+	return E_RESULT_9956::OK;
+}
+
+/// @brief 			フェードを止める(明るさはその時点のまま)
+/// @param chip 	チップ番号
+/// @param ledmask 	対象のLED(bit0がLED0)
+void PCA9956_Fade::stop(uint8_t chip, uint32_t ledmask)
+{
+	if(chip >= _chip_cnt){
+		return;
+	}
+	for(int i = 0; i < LED_CNT; i++){
+		uint16_t slotno = chip * LED_CNT + i;
+		if((ledmask & (1UL << i)) && _slot[slotno].active_pos != FADE_INACTIVE){
+			remove(slotno);
+		}
+	}
+}
+
+/// @brief 		全フェードを1tick進めて送信する
+/// @return 	OK/NG
+/// @details 	動作中のフェードだけを回すので、処理時間はフェードの数に比例する<br />
+///				1tickで割り算と浮動小数点は使わない(カーブの表を線形補間するだけ)<br />
+///				送信はチップ毎にシャドウバッファのflush1回
+E_RESULT_9956 PCA9956_Fade::tick()
+{
+	//後ろから回すと、終わったフェードを外しても未処理の物と入れ替わらない
+	for(int n = _active_cnt - 1; n >= 0; n--){
+		uint16_t slotno = _active[n];
+		T_FadeSlot &slot = _slot[slotno];
+		PCA9956_LEDDrv *drv = _drv[slot.chip];
+		uint8_t ledno = slot.ledno;
+		uint8_t *pwm = drv->pwm_shadow();
+		uint8_t value;
+
+		slot.phase += slot.step;
+		slot.acc += slot.rem;
+		if(slot.acc >= slot.ticks){
+			slot.acc -= slot.ticks;
+			slot.phase++;
+		}
+		if(slot.phase >= FADE_PHASE_ONE){
+			value = (uint8_t)(slot.from + slot.delta);
+			remove(slotno);
+		}else{
+			const uint16_t *tbl = _curve[(int)slot.curve];
+			uint32_t idx = slot.phase >> 16;
+			uint32_t frac = (slot.phase >> 8) & 0xFF;
+			int32_t ease = tbl[idx] + (((int32_t)(tbl[idx + 1] - tbl[idx]) * (int32_t)frac) >> 8);
+			value = (uint8_t)(slot.from + ((slot.delta * ease + 0x8000) >> 16));
+		}
+
+		if(pwm[ledno] != value){
+			pwm[ledno] = value;
+			drv->mark_dirty(ledno, 1);
+		}
+	}
+
+	E_RESULT_9956 ret = E_RESULT_9956::OK;
+	for(int i = 0; i < _chip_cnt; i++){
+		if(_drv[i]->flush() != E_RESULT_9956::OK){
+			ret = E_RESULT_9956::NG;
+		}
+	}
+
+	return ret;
+}
+
+/// @brief 		動作中のフェードの数
+/// @return 	フェードの数
+uint16_t PCA9956_Fade::active()
+{
+	return _active_cnt;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file PCA9956_Fade.h
+ * @author マゼピン
+ * @brief 複数チップのLEDをまとめてフェードさせる
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) マゼピン	2023
+ * @addtogroup pca9956
+ * @{
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "PCA9956_LEDDrv.h"
+
+#pragma region 定数
+
+#define FADE_CURVE_STEPS 	256			//!<	イージングカーブの表の分割数
+#define FADE_PHASE_ONE 		(1UL << 24)	//!<	フェードの進み具合の1.0(固定小数点)
+#define FADE_INACTIVE 		0xFFFF		//!<	止まっているフェードのactive_pos
+
+#pragma endregion
+
+#pragma region 列挙体
+/// @brief フェードのイージングカーブ
+enum class E_FADE_CURVE : uint8_t
+{
+	LINEAR,			///<	一定の速さ
+	EASE_IN,		///<	ゆっくり始まる(2乗)
+	EASE_OUT,		///<	ゆっくり終わる(2乗)
+	EASE_IN_OUT,	///<	ゆっくり始まってゆっくり終わる(smoothstep)
+	CURVE_CNT		///<	カーブの数
+};
+#pragma endregion 列挙体
+
+#pragma region 構造体
+/// @brief LED1個分のフェードの状態
+struct T_FadeSlot
+{
+	uint32_t phase;			///<	進み具合(FADE_PHASE_ONEで終わり)
+	uint32_t step;			///<	1tickで進む量(FADE_PHASE_ONE / ticks の商、登録時に計算しておく)
+	uint32_t rem;			///<	FADE_PHASE_ONE / ticks の余り
+	uint32_t ticks;			///<	フェードのtick数
+	uint32_t acc;			///<	余りの積算(ticksを超えたらphaseを1進める)
+	int16_t delta;			///<	目標値 - 開始値
+	uint8_t from;			///<	開始値
+	E_FADE_CURVE curve;		///<	イージングカーブ
+	uint8_t chip;			///<	チップ番号
+	uint8_t ledno;			///<	LED番号
+	uint16_t active_pos;	///<	動作中リストの位置(FADE_INACTIVEなら止まっている)
+};
+#pragma endregion 構造体
+
+/**
+ * @brief 複数チップのLEDをまとめてフェードさせるクラス
+ * @details 登録したフェードをtick()1回で全部進めて、チップ毎に1回だけ送信する<br />
+ *			メモリはコンストラクタで全LED分確保するので、登録やtick()ではメモリ確保しない
+ */
+class PCA9956_Fade
+{
+private:
+#pragma region	プライベート
+	PCA9956_LEDDrv **_drv;				//!<	チップ番号に対応するドライバー
+	uint8_t _chip_max;					//!<	登録できるチップ数
+	uint8_t _chip_cnt = 0;				//!<	登録済みのチップ数
+	T_FadeSlot *_slot;					//!<	LED毎のフェード(チップ番号 × LED_CNT + LED番号)
+	uint16_t *_active;					//!<	動作中のフェードのスロット番号
+	uint16_t _active_cnt = 0;			//!<	動作中のフェードの数
+
+	static uint16_t _curve[(int)E_FADE_CURVE::CURVE_CNT][FADE_CURVE_STEPS + 1];	//!<	イージングカーブの表(0-65535)
+	static void make_curve();			//!<	イージングカーブの表を作る
+	void remove(uint16_t slotno);		//!<	動作中リストから外す
+#pragma endregion
+public:
+	PCA9956_Fade(uint8_t chip_max);
+	~PCA9956_Fade();
+
+	E_RESULT_9956 add_driver(PCA9956_LEDDrv *drv);		//!<	ドライバーを登録する(登録順がチップ番号)
+	E_RESULT_9956 submit(uint8_t chip, uint32_t ledmask, uint8_t target, uint32_t ticks, E_FADE_CURVE curve);	//!<	フェードを登録する
+	void stop(uint8_t chip, uint32_t ledmask);			//!<	フェードを止める(明るさはその時点のまま)
+	E_RESULT_9956 tick();								//!<	全フェードを1tick進めて送信する
+	uint16_t active();									//!<	動作中のフェードの数
+};
+
+//!	@}
@@ -13,6 +13,7 @@
 
 #include "Arduino.h"
 #include "PCA9956_LEDDrv.h"
+#include "PCA9956_Trace.h"
 
 #pragma region 列挙体の計算用のオペレーター各種
 /// @brief 		REGのor計算をするためのオペレーター
@@ -74,14 +75,26 @@ uint8_t PCA9956_LEDDrv::convItoGain(uint8_t current)
 /// @return 
 E_RESULT_9956 PCA9956_LEDDrv::i2csend_serial(REG reg, std::vector<uint8_t> &data)
 {
-	size_t dtsz = data.size();
+	return i2csend_serial(reg, data.data(), data.size());
+}
+
+/// @brief 			データをI2Cポートに送信するが、連続したデータとして送信する(バッファ直接指定)
+/// @param reg 		データ送信の先頭アドレス(インクリメントフラグ込み)
+/// @param data 	送信データの先頭
+/// @param dtsz 	送信データのバイト数
+/// @return 		OK/NG
+/// @details 		vectorを作らずにシャドウバッファから直接送信するときに使う
+E_RESULT_9956 PCA9956_LEDDrv::i2csend_serial(REG reg, const uint8_t *data, size_t dtsz)
+{
+//Serial.printf("size=%d datapointer=%x  \n", dtsz, data);
 
-//Serial.printf("reg=%02x data=0x%02x %02x %02x %02x \n", (int)reg, data[0], data[1], data[2], data[3]);
-//Serial.printf("size=%d datapointer=%x  \n", dtsz, data.data());
+	if(_rec != nullptr){
+		_rec->record(micros(), _hard_addr, (uint8_t)reg, data, dtsz);
+	}
 
 	_wire->beginTransmission((uint8_t)_hard_addr);   //アドレス設定
     size_t sendregsize = _wire->write((uint8_t)reg);
-    size_t senddatasize = _wire->write(data.data(), dtsz);
+    size_t senddatasize = _wire->write(data, dtsz);
 
 //Serial.printf("sendregsize=%d senddatasize=%d  \n", sendregsize, senddatasize);
 
@@ -96,6 +109,10 @@ E_RESULT_9956 PCA9956_LEDDrv::i2csend_serial(REG reg, std::vector<uint8_t> &data
 /// @return             OK/NG
 E_RESULT_9956 PCA9956_LEDDrv::i2csend(REG reg, uint8_t data)
 {
+	if(_rec != nullptr){
+		_rec->record(micros(), _hard_addr, (uint8_t)reg, &data, 1);
+	}
+
     _wire->beginTransmission((uint8_t)_hard_addr);   //アドレス設定
 
 //Serial.printf("reg=%02x data=0x%02x \n", (int)reg, data);
@@ -151,6 +168,7 @@ E_RESULT_9956 PCA9956_LEDDrv::start(uint8_t icurrent)
 
 	//電流設定
 	uint8_t current_gain = convItoGain(icurrent);	//0-57mA → 0-255
+	_iref_base = current_gain;
 	std::vector<uint8_t> gainRec ;
 	for(int i = 0; i < LED_CNT; i++){
 		gainRec.push_back(current_gain);			//データ送信用に24個分のデータを作成する
@@ -194,7 +212,11 @@ E_RESULT_9956 PCA9956_LEDDrv::led_on(uint8_t ledno)
 /// @return 			OK/NG
 E_RESULT_9956 PCA9956_LEDDrv::led_pwn(T_LEDOrder &ledorder)
 {
+	if(ledorder.ledno >= LED_CNT){
+		return E_RESULT_9956::NG;	//シャドウバッファの外に書かないようにする
+	}
 	REG reg_adr = REG::PWM0 + ledorder.ledno;
+	_pwm_shadow[ledorder.ledno] = ledorder.ledgain;		//シャドウバッファもチップと同じ値にしておく
 	return i2csend(reg_adr | REG::MODEFLAG_INC, ledorder.ledgain);
 }
 
@@ -209,4 +231,131 @@ E_RESULT_9956 PCA9956_LEDDrv::led_pwn(std::vector<T_LEDOrder> &ledorder_lec)
 	}
 
 	return E_RESULT_9956::OK;
-}
\ No newline at end of file
+}
+
+/// @brief 			PWMシャドウバッファの先頭を取得する
+/// @return 		LED_CNT個分のPWM値の配列
+/// @details 		直接書き換えた場合は @ref mark_dirty で範囲を通知してから @ref flush すること
+uint8_t *PCA9956_LEDDrv::pwm_shadow()
+{
+	return _pwm_shadow;
+}
+
+/// @brief 			シャドウバッファの指定範囲を未送信にする
+/// @param ledno 	先頭のLED番号
+/// @param cnt 		LEDの個数
+void PCA9956_LEDDrv::mark_dirty(uint8_t ledno, uint8_t cnt)
+{
+	if(cnt == 0 || ledno >= LED_CNT){
+		return;
+	}
+	uint16_t last = (uint16_t)ledno + cnt;		//uint8_tだと255を超えた時に範囲が消える
+	if(last > LED_CNT){
+		last = LED_CNT;
+	}
+	if(ledno < _dirty_lo){
+		_dirty_lo = ledno;
+	}
+	if(last > _dirty_hi){
+		_dirty_hi = (uint8_t)last;
+	}
+}
+
+/// @brief 			シャドウバッファの未送信範囲を1回の連続送信で出力する
+/// @return 		OK/NG
+/// @details 		未送信範囲の先頭から最後までをオートインクリメントでまとめて送る<br />
+///					間に変更の無いLEDが挟まっていても、1バイトずつ送るよりアドレス分のオーバーヘッドが少ない
+E_RESULT_9956 PCA9956_LEDDrv::flush()
+{
+	if(_dirty_lo >= _dirty_hi){
+		return E_RESULT_9956::OK;	//送る物が無い
+	}
+
+	REG reg_adr = REG::PWM0 + _dirty_lo;
+	E_RESULT_9956 ret = i2csend_serial(reg_adr | REG::MODEFLAG_INC, &_pwm_shadow[_dirty_lo], _dirty_hi - _dirty_lo);
+
+	_dirty_lo = LED_CNT;
+	_dirty_hi = 0;
+
+	return ret;
+}
+
+/// @brief 			シャドウバッファの未送信範囲を取得する
+/// @param lo 		未送信の先頭LED番号
+/// @param hi 		未送信の最終LED番号+1
+/// @return 		未送信があればtrue
+/// @details 		次のflushで送る範囲なので、この中のLEDは書き換えても送信バイト数が増えない
+bool PCA9956_LEDDrv::dirty_range(uint8_t &lo, uint8_t &hi)
+{
+	lo = _dirty_lo;
+	hi = _dirty_hi;
+
+	return _dirty_lo < _dirty_hi;
+}
+
+/// @brief 			指定のLED番号のIREFを直接指定
+/// @param ledno 	LED番号
+/// @param gain 	IREFの値(0-255)
+/// @return 		OK/NG
+E_RESULT_9956 PCA9956_LEDDrv::led_iref(uint8_t ledno, uint8_t gain)
+{
+	if(ledno >= LED_CNT){
+		return E_RESULT_9956::NG;		//IREF23より後ろはIREFALLなど別のレジスタ
+	}
+	REG reg_adr = REG::IREF0 + ledno;
+	return i2csend(reg_adr | REG::MODEFLAG_INC, gain);
+}
+
+/// @brief 			複数のLEDのIREFを同じ値にする
+/// @param ledmask 	対象のLED(bit0がLED0)
+/// @param gain 	IREFの値(0-255)
+/// @return 		OK/NG
+/// @details 		番号が連続しているLEDはオートインクリメントで1回にまとめて送る
+E_RESULT_9956 PCA9956_LEDDrv::led_iref_mask(uint32_t ledmask, uint8_t gain)
+{
+	uint8_t data[LED_CNT];
+	E_RESULT_9956 ret = E_RESULT_9956::OK;
+
+	memset(data, gain, sizeof(data));
+	ledmask &= (1UL << LED_CNT) - 1;
+	for(int lo = 0; ledmask != 0; ){
+		while(!(ledmask & (1UL << lo))){
+			lo++;
+		}
+		int hi = lo;
+		while(hi < LED_CNT && (ledmask & (1UL << hi))){
+			ledmask &= ~(1UL << hi);
+			hi++;
+		}
+		if(i2csend_serial((REG::IREF0 + (uint8_t)lo) | REG::MODEFLAG_INC, data, hi - lo) != E_RESULT_9956::OK){
+			ret = E_RESULT_9956::NG;
+		}
+		lo = hi;
+	}
+
+	return ret;
+}
+
+/// @brief 			startで設定したIREFの値
+/// @return 		IREFの値(0-255)
+uint8_t PCA9956_LEDDrv::iref_base()
+{
+	return _iref_base;
+}
+
+/// @brief 			送信したデータを記録する
+/// @param rec 		記録先(nullptrで記録を止める)
+/// @details 		最適化の前後で記録を取って tools/trace_replay で比較すると、表示結果が変わっていないか確認できる
+void PCA9956_LEDDrv::set_recorder(PCA9956_Recorder *rec)
+{
+	_rec = rec;
+}
+
+/// @brief 			記録にフレーム区切りを入れる
+/// @details 		区切り毎にレジスタの状態を比較するので、1回分の表示を出し終わったところで呼ぶ
+void PCA9956_LEDDrv::trace_frame()
+{
+	if(_rec != nullptr){
+		_rec->mark_frame(micros());
+	}
+}
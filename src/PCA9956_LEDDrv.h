@@ -19,6 +19,8 @@
 #include "Arduino.h"
 #include "Wire.h"
 
+class PCA9956_Recorder;		//	PCA9956_Trace.h
+
 //  参考資料
 //  https://www.nxp.com/docs/en/data-sheet/PCA9956B.pdf
 
@@ -197,11 +199,17 @@ private:
 	const uint8_t LED_DEFAULT_CURRENT = 5;	//!<	5mA程度をデフォルト値にする<br />
 											//!<	5mAなら、1005というSMD LEDでも大抵は耐えられる
 	uint8_t _hard_addr = 0;				 	//!<	ボードのアドレス
+	uint8_t _pwm_shadow[LED_CNT] = {0};		//!<	PWMレジスタのシャドウバッファ(チップ側の値と同じ物を持つ)
+	uint8_t _dirty_lo = LED_CNT;			//!<	未送信の先頭LED番号(LED_CNTなら未送信無し)
+	uint8_t _dirty_hi = 0;					//!<	未送信の最終LED番号+1
+	PCA9956_Recorder *_rec = nullptr;		//!<	送信したデータの記録先(nullptrなら記録しない)
+	uint8_t _iref_base = 0;					//!<	startで設定したIREFの値
 
 	uint8_t convItoGain(uint8_t current);							//!<	LEDの電流をPCA9956Bのデータに変換する
 	E_RESULT_9956 i2csend(REG reg, uint8_t data);				 	//!<	データをI2Cポートに送信する
 	E_RESULT_9956 i2csend(REG reg, std::vector<uint8_t> &data); 	//!<	データをI2Cポートに送信する(複数データ)
 	E_RESULT_9956 i2csend_serial(REG reg, std::vector<uint8_t> &data);	//!<	データをI2Cポートに送信するが、連続したデータとして送信する
+	E_RESULT_9956 i2csend_serial(REG reg, const uint8_t *data, size_t size);	//!<	データをI2Cポートに送信するが、連続したデータとして送信する(バッファ直接指定)
 
 	//オペレーター
 
@@ -217,6 +225,16 @@ public:
 	E_RESULT_9956 led_on(uint8_t ledno);						  	//!<	指定のLED番号をON
 	E_RESULT_9956 led_pwn(T_LEDOrder &ledorder);				  	//!<	指定のLED番号の明るさを指定
 	E_RESULT_9956 led_pwn(std::vector<T_LEDOrder> &ledorder_lec); 	//!<	指定のLED番号の明るさを指定(複数一括指定)
+
+	uint8_t *pwm_shadow();											//!<	PWMシャドウバッファの先頭を取得する(LED_CNT個分)
+	void mark_dirty(uint8_t ledno, uint8_t cnt);					//!<	シャドウバッファの指定範囲を未送信にする
+	E_RESULT_9956 flush();											//!<	シャドウバッファの未送信範囲を1回の連続送信で出力する
+	bool dirty_range(uint8_t &lo, uint8_t &hi);						//!<	シャドウバッファの未送信範囲を取得する
+	E_RESULT_9956 led_iref(uint8_t ledno, uint8_t gain);			//!<	指定のLED番号のIREFを直接指定
+	E_RESULT_9956 led_iref_mask(uint32_t ledmask, uint8_t gain);	//!<	複数のLEDのIREFを同じ値にする(連続した所は1回で送る)
+	uint8_t iref_base();											//!<	startで設定したIREFの値
+	void set_recorder(PCA9956_Recorder *rec);						//!<	送信したデータを記録する(nullptrで記録を止める)
+	void trace_frame();												//!<	記録にフレーム区切りを入れる
 	// E_RESULT_9956 led_setCurrent(uint8_t current);				  	//!<	指定のLED番号の電流を指定
 	// E_RESULT_9956 led_setCurrent(T_LEDCurrent &current);		  	//!<	指定のLED番号の電流を指定(一括指定)
 };
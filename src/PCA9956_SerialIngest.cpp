@@ -0,0 +1,324 @@
+/**
+ * @file PCA9956_SerialIngest.cpp
+ * @author マゼピン
+ * @brief シリアル経由でPCからLEDのフレームを流し込む受信処理
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "Arduino.h"
+#include "PCA9956_SerialIngest.h"
+
+#define RING_MASK	(INGEST_RING_SIZE - 1)	//	リングバッファの添字計算用
+
+/// @brief コンストラクタ
+PCA9956_SerialIngest::PCA9956_SerialIngest()
+{
+	_fps_start_us = micros();
+}
+
+/// @brief デストラクタ
+PCA9956_SerialIngest::~PCA9956_SerialIngest()
+{
+}
+
+/// @brief 		ドライバーを登録する
+/// @param drv 	ドライバーオブジェクト(登録した順番がパケットのCHIP番号になる)
+/// @return 	OK/NG(登録数オーバー)
+E_RESULT_9956 PCA9956_SerialIngest::add_driver(PCA9956_LEDDrv *drv)
+{
+	if(_drv_cnt >= INGEST_CHIP_MAX){
+		return E_RESULT_9956::NG;
+	}
+	_drv[_drv_cnt++] = drv;
+
+	return E_RESULT_9956::OK;
+}
+
+/// @brief 			シリアルの受信コールバックでリングバッファに取り込む
+/// @param serial 	受信に使うシリアル(Serial.begin済みのもの)
+/// @details 		UARTの割り込みで溜まったデータを、受信コールバックでリングバッファへ直接読み込む<br />
+///					loop側では @ref poll を呼ぶだけで良い<br />
+///					UART側で溢れたバイト数は分からないので、溢れた回数を uart_overflows に数える
+void PCA9956_SerialIngest::begin(HardwareSerial *serial)
+{
+	_serial = serial;
+	_serial->onReceive([this]() { fill_from_serial(); });
+	_serial->onReceiveError([this](hardwareSerial_error_t err) {
+		if(err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR){
+			_stats.uart_overflows++;
+		}
+	});
+}
+
+/// @brief 		シリアルの受信データをリングバッファへ直接読み込む
+/// @details 	リングの空き領域に直接readするので、間に一時バッファを挟まない<br />
+///				リングが一杯の時は読まずにUART側のバッファに残しておく(空いたら @ref poll から読む)
+void PCA9956_SerialIngest::fill_from_serial()
+{
+	//受信コールバックとpollの両方から呼ばれるので、書き込むのは片方だけにする
+	//(実行中の方がavailableが0になるまで読むので、もう片方は何もしなくて良い)
+	if(__atomic_test_and_set(&_filling, __ATOMIC_ACQUIRE)){
+		return;
+	}
+
+	for(;;){
+		uint32_t head = _head;
+		uint32_t used = head - _tail;
+		uint32_t space = INGEST_RING_SIZE - used;
+		size_t avail = _serial->available();
+		if(space == 0 || avail == 0){
+			break;
+		}
+
+		//折り返しまでの連続領域にだけ読み込む(残りは次のループで)
+		uint32_t idx = head & RING_MASK;
+		uint32_t chunk = INGEST_RING_SIZE - idx;
+		if(chunk > space){
+			chunk = space;
+		}
+		if(chunk > avail){
+			chunk = avail;
+		}
+		size_t readsize = _serial->read(&_ring[idx], chunk);
+		if(readsize == 0){
+			break;
+		}
+
+		stamp(head);
+		__sync_synchronize();
+		_head = head + readsize;
+	}
+
+	__atomic_clear(&_filling, __ATOMIC_RELEASE);
+}
+
+/// @brief 		受信データをリングバッファに入れる
+/// @param data 受信データ
+/// @param size 受信データのバイト数
+/// @return 	リングバッファに入れたバイト数(溢れた分は捨てる)
+/// @details 	シリアル以外(ESP-NOWやUDPなど)から受信する場合や、自分でreadする場合はこちらを使う
+size_t PCA9956_SerialIngest::feed(const uint8_t *data, size_t size)
+{
+	uint32_t head = _head;
+	uint32_t used = head - _tail;
+	uint32_t space = INGEST_RING_SIZE - used;
+	size_t putsize = size;
+
+	if(putsize > space){
+		_stats.overflows += putsize - space;
+		putsize = space;
+	}
+	if(putsize == 0){
+		return 0;
+	}
+
+	uint32_t idx = head & RING_MASK;
+	uint32_t first = INGEST_RING_SIZE - idx;
+	if(first > putsize){
+		first = putsize;
+	}
+	memcpy(&_ring[idx], data, first);
+	memcpy(&_ring[0], data + first, putsize - first);
+
+	stamp(head);
+	__sync_synchronize();
+	_head = head + putsize;
+
+	return putsize;
+}
+
+/// @brief 		書き込んだ位置と時刻を覚える
+/// @param head 書き込みを始めた位置
+/// @details 	受信側から書き込む毎に呼ぶ(_headを進める前)
+void PCA9956_SerialIngest::stamp(uint32_t head)
+{
+	T_IngestStamp &st = _stamp[_stamp_cnt & (INGEST_STAMP_CNT - 1)];
+	st.us = micros();
+	st.pos = head;
+	_stamp_cnt = _stamp_cnt + 1;
+}
+
+/// @brief 		リング上の位置のバイトを受信した時刻
+/// @param pos 	リング上の位置(_tailと同じ数え方)
+/// @return 	そのバイトを書き込んだ時の時刻(us)
+/// @details 	pos以前に書き込みを始めた中で一番新しいものを探す<br />
+///				細切れの受信が続いて記録が上書きされていたら、残っている一番古い時刻にする(実際より短めの値になる)
+uint32_t PCA9956_SerialIngest::arrival_us(uint32_t pos)
+{
+	uint32_t cnt = _stamp_cnt;
+	uint32_t valid = (cnt < INGEST_STAMP_CNT) ? cnt : INGEST_STAMP_CNT;
+	int32_t best = -1;
+	int32_t oldest = -1;
+
+	for(uint32_t i = 0; i < valid; i++){
+		int32_t no = (int32_t)((cnt - 1 - i) & (INGEST_STAMP_CNT - 1));		//新しい順
+		if((int32_t)(pos - _stamp[no].pos) >= 0){
+			best = no;
+			break;
+		}
+		oldest = no;
+	}
+	if(best < 0){
+		best = oldest;
+	}
+
+	return (best < 0) ? micros() : _stamp[best].us;
+}
+
+/// @brief 		読み出し位置からのオフセットで1バイト取得する
+/// @param ofs 	読み出し位置からのオフセット
+/// @return 	データ
+uint8_t PCA9956_SerialIngest::peek(uint32_t ofs)
+{
+	return _ring[(_tail + ofs) & RING_MASK];
+}
+
+/// @brief 		リング上のデータのCRC-8を計算する
+/// @param ofs 	読み出し位置からのオフセット
+/// @param len 	バイト数
+/// @return 	CRC-8(多項式0x07,初期値0x00)
+/// @details 	パケットを取り出さずにリング上で直接計算する
+uint8_t PCA9956_SerialIngest::crc8(uint32_t ofs, uint32_t len)
+{
+	uint8_t crc = 0;
+	for(uint32_t i = 0; i < len; i++){
+		crc ^= peek(ofs + i);
+		for(int bit = 0; bit < 8; bit++){
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+/// @brief 		リング上のデータをシャドウバッファへ書き込む
+/// @param ofs 	読み出し位置からのオフセット
+/// @param dst 	書き込み先(シャドウバッファ)
+/// @param len 	バイト数
+/// @details 	折り返しがあっても最大2回のmemcpyで済む
+void PCA9956_SerialIngest::copy_to_shadow(uint32_t ofs, uint8_t *dst, uint8_t len)
+{
+	uint32_t idx = (_tail + ofs) & RING_MASK;
+	uint32_t first = INGEST_RING_SIZE - idx;
+	if(first > len){
+		first = len;
+	}
+	memcpy(dst, &_ring[idx], first);
+	memcpy(dst + first, &_ring[0], len - first);
+}
+
+/// @brief 		全チップの変更範囲を送信する
+void PCA9956_SerialIngest::flush_frame()
+{
+	for(int i = 0; i < _drv_cnt; i++){
+		_drv[i]->flush();
+	}
+
+	if(_in_frame){
+		uint32_t latency = micros() - _frame_rx_us;
+		_stats.last_latency_us = latency;
+		if(latency > _stats.max_latency_us){
+			_stats.max_latency_us = latency;
+		}
+	}
+	_stats.frames++;
+	_fps_frames++;
+	_in_frame = false;
+}
+
+/// @brief 		リングバッファのパケットを処理する
+/// @details 	loopから定期的に呼ぶこと<br />
+///				ヘッダーがおかしい、CRCが合わないときはSYNCを1バイト捨てて次のSYNCを探し直す<br />
+///				beginしている場合は、リングが一杯でUARTに残っていた分もここで読み込む<br />
+///				feedを使う場合は、UARTなどの受信側のバッファは自分で読み出すこと
+void PCA9956_SerialIngest::poll()
+{
+	if(_serial != nullptr){
+		fill_from_serial();
+	}
+
+	for(;;){
+		uint32_t avail = _head - _tail;
+		__sync_synchronize();
+
+		//SYNCを探す
+		while(avail > 0 && peek(0) != INGEST_SYNC){
+			_tail = _tail + 1;
+			avail--;
+		}
+		if(avail < INGEST_HEADER_SIZE + 1){
+			return;		//ヘッダーが揃っていない
+		}
+
+		uint8_t chip = peek(1);
+		uint8_t start = peek(2);
+		uint8_t len = peek(3);
+		uint32_t pktsize = INGEST_HEADER_SIZE + len + 1;
+
+		if(len > 0 && (start >= LED_CNT || len > LED_CNT - start)){
+			_tail = _tail + 1;	//範囲外なのでSYNCではなかったとみなす
+			continue;
+		}
+		if(avail < pktsize){
+			return;		//データが揃っていない
+		}
+		if(crc8(1, INGEST_HEADER_SIZE - 1 + len) != peek(pktsize - 1)){
+			_stats.crc_errors++;
+			_tail = _tail + 1;
+			continue;
+		}
+
+		if(!_in_frame){
+			_frame_rx_us = arrival_us(_tail);	//フレームの最初のパケットのSYNCを受信した時刻
+			_in_frame = true;
+		}
+
+		if(len == 0){
+			flush_frame();		//フレーム終端マーカー
+		}else if(chip < _drv_cnt){
+			PCA9956_LEDDrv *drv = _drv[chip];
+			copy_to_shadow(INGEST_HEADER_SIZE, drv->pwm_shadow() + start, len);
+			drv->mark_dirty(start, len);
+		}
+		_stats.packets++;
+		_tail = _tail + pktsize;
+	}
+}
+
+/// @brief 		統計を取得する
+/// @return 	統計
+const T_IngestStats &PCA9956_SerialIngest::stats()
+{
+	return _stats;
+}
+
+/// @brief 		前回呼んでからのフレームレート
+/// @return 	fps × 100
+/// @details 	呼ぶ毎に数え直すので、一定周期で呼べばその間のフレームレートになる
+uint32_t PCA9956_SerialIngest::fps_x100()
+{
+	uint32_t now = micros();
+	uint32_t elapsed_us = now - _fps_start_us;
+	uint32_t frames = _fps_frames;
+
+	_fps_frames = 0;
+	_fps_start_us = now;
+	if(elapsed_us == 0){
+		return 0;
+	}
+
+	return (uint32_t)((uint64_t)frames * 100000000 / elapsed_us);
+}
+
+/// @brief 		統計をクリアする
+void PCA9956_SerialIngest::reset_stats()
+{
+	_stats = {0};
+	_fps_frames = 0;
+	_fps_start_us = micros();
+}
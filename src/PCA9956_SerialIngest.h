@@ -0,0 +1,111 @@
+/**
+ * @file PCA9956_SerialIngest.h
+ * @author マゼピン
+ * @brief シリアル経由でPCからLEDのフレームを流し込む受信処理
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) マゼピン	2023
+ * @addtogroup pca9956
+ * @{
+ *
+ * パケットの形式(1パケット = 5 + LEN バイト)
+ * | 位置 		| 内容 	| 説明 												|
+ * |-----------|-------|---------------------------------------------------|
+ * | 0 		| SYNC 	| 0xA5 固定 										|
+ * | 1 		| CHIP 	| 登録したドライバーの番号(0～) 						|
+ * | 2 		| START | 書き込み先の先頭LED番号(0～23) 					|
+ * | 3 		| LEN 	| PWM値の個数(1～24)、0ならフレーム終端マーカー 		|
+ * | 4～ 		| DATA 	| PWM値 × LEN 										|
+ * | 4+LEN 	| CRC 	| CHIP～DATAまでのCRC-8(多項式0x07,初期値0x00) 		|
+ *
+ * DATAはリングバッファからシャドウバッファへ直接書き込み、フレーム終端マーカーで
+ * 全チップの変更範囲をまとめて送信する
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "PCA9956_LEDDrv.h"
+
+#pragma region 定数
+
+#define INGEST_SYNC 		0xA5	//!<	パケットの先頭
+#define INGEST_HEADER_SIZE 	4		//!<	SYNC,CHIP,START,LEN
+#define INGEST_RING_SIZE 	1024	//!<	受信リングバッファのサイズ(2のべき乗にすること)
+#define INGEST_CHIP_MAX 	8		//!<	登録できるドライバーの数
+#define INGEST_STAMP_CNT 	16		//!<	受信時刻を覚えておく回数(2のべき乗にすること)
+
+static_assert((INGEST_RING_SIZE & (INGEST_RING_SIZE - 1)) == 0, "INGEST_RING_SIZE must be a power of two");
+static_assert((INGEST_STAMP_CNT & (INGEST_STAMP_CNT - 1)) == 0, "INGEST_STAMP_CNT must be a power of two");
+
+#pragma endregion
+
+#pragma region 構造体
+/// @brief 受信処理の統計
+struct T_IngestStats
+{
+	uint32_t frames;			///<	送信したフレーム数
+	uint32_t packets;			///<	受け付けたパケット数
+	uint32_t crc_errors;		///<	CRCエラーで捨てたパケット数
+	uint32_t overflows;			///<	feedでリングバッファが溢れて捨てたバイト数(beginで受信する時はUART側に残すので増えない)
+	uint32_t uart_overflows;	///<	beginで受信する時に、UARTの受信バッファかFIFOが溢れた回数(バイト数ではない)
+	uint32_t last_latency_us;	///<	直前フレームの受信～I2C送信完了までの時間(us)
+	uint32_t max_latency_us;	///<	受信～I2C送信完了までの時間の最大値(us)
+};
+
+/// @brief リングバッファに書き込んだ位置と時刻
+struct T_IngestStamp
+{
+	uint32_t pos;				///<	書き込みを始めた位置(_headの値)
+	uint32_t us;				///<	書き込んだ時刻(us)
+};
+#pragma endregion 構造体
+
+/**
+ * @brief シリアル受信したフレームをPCA9956_LEDDrvに流し込むクラス
+ *
+ */
+class PCA9956_SerialIngest
+{
+private:
+#pragma region	プライベート
+	uint8_t _ring[INGEST_RING_SIZE];					//!<	受信リングバッファ
+	volatile uint32_t _head = 0;						//!<	書き込み位置(受信側だけが更新する)
+	volatile uint32_t _tail = 0;						//!<	読み出し位置(poll側だけが更新する)
+	T_IngestStamp _stamp[INGEST_STAMP_CNT] = {{0, 0}};	//!<	最近の書き込みの位置と時刻(受信側だけが更新する)
+	volatile uint32_t _stamp_cnt = 0;					//!<	これまでの書き込み回数
+	bool _filling = false;								//!<	fill_from_serialの実行中ならtrue(受信コールバックとpollの排他)
+	uint32_t _frame_rx_us = 0;							//!<	処理中のフレームの最初のバイトの受信時刻
+	bool _in_frame = false;								//!<	フレームの途中ならtrue
+	PCA9956_LEDDrv *_drv[INGEST_CHIP_MAX] = {nullptr};	//!<	CHIP番号に対応するドライバー
+	uint8_t _drv_cnt = 0;								//!<	登録済みのドライバー数
+	HardwareSerial *_serial = nullptr;					//!<	受信に使うシリアル
+	T_IngestStats _stats = {0};							//!<	統計
+	uint32_t _fps_frames = 0;							//!<	前回fps_x100を呼んでからのフレーム数
+	uint32_t _fps_start_us = 0;							//!<	前回fps_x100を呼んだ時刻
+
+	uint8_t peek(uint32_t ofs);							//!<	読み出し位置からのオフセットで1バイト取得する
+	uint8_t crc8(uint32_t ofs, uint32_t len);			//!<	リング上のデータのCRC-8を計算する
+	void copy_to_shadow(uint32_t ofs, uint8_t *dst, uint8_t len);	//!<	リング上のデータをシャドウバッファへ書き込む
+	void flush_frame();									//!<	全チップの変更範囲を送信する
+	void fill_from_serial();							//!<	シリアルの受信データをリングバッファへ直接読み込む
+	void stamp(uint32_t head);							//!<	書き込んだ位置と時刻を覚える
+	uint32_t arrival_us(uint32_t pos);					//!<	リング上の位置のバイトを受信した時刻
+
+#pragma endregion
+public:
+	PCA9956_SerialIngest();
+	~PCA9956_SerialIngest();
+
+	E_RESULT_9956 add_driver(PCA9956_LEDDrv *drv);		//!<	ドライバーを登録する(登録順がCHIP番号)
+	void begin(HardwareSerial *serial);					//!<	シリアルの受信コールバックでリングバッファに取り込む
+	size_t feed(const uint8_t *data, size_t size);		//!<	受信データをリングバッファに入れる
+	void poll();										//!<	リングバッファのパケットを処理する
+	const T_IngestStats &stats();						//!<	統計を取得する
+	uint32_t fps_x100();								//!<	前回呼んでからのフレームレート(×100)
+	void reset_stats();									//!<	統計をクリアする
+};
+
+//!	@}
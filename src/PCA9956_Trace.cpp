@@ -0,0 +1,332 @@
+/**
+ * @file PCA9956_Trace.cpp
+ * @author マゼピン
+ * @brief PCA9956_LEDDrvが発行したI2Cトランザクションの記録と再生
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <string.h>
+#include "PCA9956_Trace.h"
+
+static const uint8_t TRACE_MAGIC[TRACE_MAGIC_SIZE] = {'P', '9', 'T', '1'};	//	トレースの先頭
+
+#pragma region レコーダー
+/// @brief 			コンストラクタ
+/// @param capacity 記録できる最大バイト数(最初に確保して、記録中はメモリ確保しない)
+PCA9956_Recorder::PCA9956_Recorder(size_t capacity)
+{
+	_capacity = capacity;
+	_buf.reserve(capacity);
+	clear();
+}
+
+/// @brief デストラクタ
+PCA9956_Recorder::~PCA9956_Recorder()
+{
+}
+
+/// @brief 		32bit値をリトルエンディアンで追加する
+/// @param val 	値
+void PCA9956_Recorder::put32(uint32_t val)
+{
+	_buf.push_back((uint8_t)val);
+	_buf.push_back((uint8_t)(val >> 8));
+	_buf.push_back((uint8_t)(val >> 16));
+	_buf.push_back((uint8_t)(val >> 24));
+}
+
+/// @brief 			トランザクションを記録する
+/// @param time_us 	時刻(us)
+/// @param addr 	I2Cアドレス
+/// @param reg 		制御レジスタ
+/// @param data 	データ
+/// @param len 		データのバイト数(255まで)
+void PCA9956_Recorder::record(uint32_t time_us, uint8_t addr, uint8_t reg, const uint8_t *data, size_t len)
+{
+	if(_overflow || len > 0xFF || _buf.size() + TRACE_REC_HEADER + len > _capacity){
+		_overflow = true;	//途中が抜けたトレースは比較に使えないので、以降は記録しない
+		return;
+	}
+
+	put32(time_us);
+	_buf.push_back(addr);
+	_buf.push_back(reg);
+	_buf.push_back((uint8_t)len);
+	_buf.insert(_buf.end(), data, data + len);
+}
+
+/// @brief 			フレーム区切りを記録する
+/// @param time_us 	時刻(us)
+void PCA9956_Recorder::mark_frame(uint32_t time_us)
+{
+	record(time_us, TRACE_FRAME_ADDR, 0, nullptr, 0);
+}
+
+/// @brief 記録を消す
+void PCA9956_Recorder::clear()
+{
+	_buf.clear();
+	_buf.insert(_buf.end(), TRACE_MAGIC, TRACE_MAGIC + TRACE_MAGIC_SIZE);
+	_overflow = false;
+}
+
+/// @brief 		トレースの先頭
+/// @return 	トレース
+const uint8_t *PCA9956_Recorder::data()
+{
+	return _buf.data();
+}
+
+/// @brief 		トレースのバイト数
+/// @return 	バイト数
+size_t PCA9956_Recorder::size()
+{
+	return _buf.size();
+}
+
+/// @brief 		溢れて記録を止めたか
+/// @return 	溢れていればtrue
+bool PCA9956_Recorder::overflow()
+{
+	return _overflow;
+}
+#pragma endregion
+
+#pragma region シミュレーター
+/// @brief 		レジスタを電源投入時の値にする
+/// @param r 	TRACE_REG_CNT個のレジスタ
+/// @note 		Table 7. Register summary 参照
+static void power_up(uint8_t *r)
+{
+	memset(r, 0, TRACE_REG_CNT);
+	r[0x00] = 0x89;				//MODE1
+	r[0x01] = 0x05;				//MODE2
+	memset(&r[0x02], 0xAA, 6);	//LEDOUT0～5 (全部PWM)
+	r[0x08] = 0xFF;				//GRPPWM
+}
+
+/// @brief コンストラクタ
+PCA9956_Sim::PCA9956_Sim()
+{
+}
+
+/// @brief デストラクタ
+PCA9956_Sim::~PCA9956_Sim()
+{
+}
+
+/// @brief 全チップを消す
+void PCA9956_Sim::reset()
+{
+	_chip_cnt = 0;
+}
+
+/// @brief 		アドレスに対応するチップ
+/// @param addr I2Cアドレス
+/// @return 	チップの番号(-1ならチップ数オーバー)
+/// @details 	初めて出てきたアドレスは電源投入時の値で追加する
+int PCA9956_Sim::chip(uint8_t addr)
+{
+	for(int i = 0; i < _chip_cnt; i++){
+		if(_addr[i] == addr){
+			return i;
+		}
+	}
+	if(_chip_cnt >= TRACE_SIM_CHIP_MAX){
+		return -1;
+	}
+
+	int no = _chip_cnt++;
+	_addr[no] = addr;
+	power_up(_regs[no]);
+
+	return no;
+}
+
+/// @brief 		トランザクションを1つ反映する
+/// @param addr I2Cアドレス
+/// @param reg 	制御レジスタ(bit7がオートインクリメント)
+/// @param data データ
+/// @param len 	データのバイト数
+void PCA9956_Sim::apply(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len)
+{
+	int no = chip(addr);
+	if(no < 0){
+		return;
+	}
+	uint8_t *r = _regs[no];
+	bool autoinc = (reg & 0x80) != 0;
+	uint8_t ptr = reg & 0x7F;
+
+	for(size_t i = 0; i < len; i++){
+		if(ptr < TRACE_REG_CNT){
+			r[ptr] = data[i];
+		}
+		if(!autoinc){
+			continue;	//インクリメントしなければ同じレジスタに上書き
+		}
+
+		//折り返しの範囲はMODE1のAI1:AI0で決まる(Table 6. Auto-Increment options)
+		uint8_t lo = 0x00, hi = 0x3E;
+		switch((r[0x00] >> 5) & 0x03){
+		case 1:	lo = 0x0A; hi = 0x21; break;
+		case 2:	lo = 0x00; hi = 0x39; break;
+		case 3:	lo = 0x08; hi = 0x21; break;
+		default: break;
+		}
+		ptr = (ptr >= hi) ? lo : ptr + 1;
+	}
+}
+
+/// @brief 		チップのレジスタ
+/// @param addr I2Cアドレス
+/// @return 	TRACE_REG_CNT個のレジスタ(一度も送信されていなければnullptr)
+const uint8_t *PCA9956_Sim::regs(uint8_t addr)
+{
+	for(int i = 0; i < _chip_cnt; i++){
+		if(_addr[i] == addr){
+			return _regs[i];
+		}
+	}
+
+	return nullptr;
+}
+
+/// @brief 				2つのシミュレーターの状態を比較する
+/// @param other 		比較相手
+/// @param diff_addr 	最初に違ったチップのアドレス(nullptr可)
+/// @param diff_reg 	最初に違ったレジスタ(nullptr可)
+/// @return 			一致していればtrue
+/// @details 			片方にしか出てこないチップは電源投入時の値と比較する
+bool PCA9956_Sim::equals(PCA9956_Sim &other, uint8_t *diff_addr, uint8_t *diff_reg)
+{
+	PCA9956_Sim *side[2] = {this, &other};
+	uint8_t initial[TRACE_REG_CNT];
+	power_up(initial);
+
+	for(int s = 0; s < 2; s++){
+		for(int i = 0; i < side[s]->_chip_cnt; i++){
+			uint8_t addr = side[s]->_addr[i];
+			const uint8_t *a = regs(addr) ? regs(addr) : initial;
+			const uint8_t *b = other.regs(addr) ? other.regs(addr) : initial;
+			for(int reg = 0; reg < TRACE_REG_CNT; reg++){
+				if(a[reg] != b[reg]){
+					if(diff_addr) *diff_addr = addr;
+					if(diff_reg) *diff_reg = (uint8_t)reg;
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+#pragma endregion
+
+#pragma region 再生
+/// @brief 			トレースから次のレコードを取り出す
+/// @param trace 	トレース
+/// @param size 	トレースのバイト数
+/// @param pos 		読み出し位置(0から始めて、呼ぶ毎に進む)
+/// @param rec 		取り出したレコード
+/// @return 		取り出せたらtrue(終端か壊れたレコードならfalse)
+bool trace_next(const uint8_t *trace, size_t size, size_t *pos, T_TraceRec *rec)
+{
+	if(*pos == 0){
+		if(size < TRACE_MAGIC_SIZE || memcmp(trace, TRACE_MAGIC, TRACE_MAGIC_SIZE) != 0){
+			return false;
+		}
+		*pos = TRACE_MAGIC_SIZE;
+	}
+	if(*pos + TRACE_REC_HEADER > size){
+		return false;
+	}
+
+	const uint8_t *p = trace + *pos;
+	rec->time_us = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	rec->addr = p[4];
+	rec->reg = p[5];
+	rec->len = p[6];
+	rec->data = p + TRACE_REC_HEADER;
+	if(*pos + TRACE_REC_HEADER + rec->len > size){
+		return false;
+	}
+	*pos += TRACE_REC_HEADER + rec->len;
+
+	return true;
+}
+
+/// @brief 			トレースを次のフレーム区切りまで再生する
+/// @param trace 	トレース
+/// @param size 	トレースのバイト数
+/// @param pos 		読み出し位置
+/// @param sim 		反映先のシミュレーター
+/// @param tx 		トランザクション数に加算する(nullptr可)
+/// @param bytes 	I2Cバス上のバイト数に加算する(nullptr可)
+/// @return 		1フレーム分再生できたらtrue(もう残っていなければfalse)
+/// @details 		最後のフレーム区切りの後ろにレコードがあれば、それも1フレームとして扱う
+bool trace_replay_frame(const uint8_t *trace, size_t size, size_t *pos, PCA9956_Sim &sim, uint32_t *tx, uint32_t *bytes)
+{
+	T_TraceRec rec;
+	bool played = false;
+
+	while(trace_next(trace, size, pos, &rec)){
+		if(rec.addr == TRACE_FRAME_ADDR){
+			return true;
+		}
+		sim.apply(rec.addr, rec.reg, rec.data, rec.len);
+		if(tx) *tx += 1;
+		if(bytes) *bytes += 2 + rec.len;	//アドレス + 制御レジスタ + データ
+		played = true;
+	}
+
+	return played;
+}
+
+/// @brief 			2つのトレースを再生して比較する
+/// @param a 		トレースA(基準)
+/// @param asize 	トレースAのバイト数
+/// @param b 		トレースB(比較対象)
+/// @param bsize 	トレースBのバイト数
+/// @param diff 	比較結果
+/// @details 		フレーム区切り毎にレジスタの状態を比較する<br />
+///					フレーム数が違う場合は、短い方は最後の状態のままとして比較を続ける
+void trace_compare(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize, T_TraceDiff &diff)
+{
+	static PCA9956_Sim sim[2];	//レジスタの配列が大きいのでスタックに置かない
+	const uint8_t *trace[2] = {a, b};
+	size_t size[2] = {asize, bsize};
+	size_t pos[2] = {0, 0};
+
+	memset(&diff, 0, sizeof(diff));
+	diff.first_mismatch = -1;
+	sim[0].reset();
+	sim[1].reset();
+
+	for(int32_t frame = 0; ; frame++){
+		bool played = false;
+		for(int s = 0; s < 2; s++){
+			if(trace_replay_frame(trace[s], size[s], &pos[s], sim[s], &diff.transactions[s], &diff.bytes[s])){
+				diff.frames[s]++;
+				played = true;
+			}
+		}
+		if(!played){
+			break;
+		}
+		if(!sim[0].equals(sim[1], nullptr, nullptr)){
+			diff.frame_mismatch++;
+			if(diff.first_mismatch < 0){
+				diff.first_mismatch = frame;
+			}
+		}
+	}
+
+	diff.final_match = sim[0].equals(sim[1], &diff.diff_addr, &diff.diff_reg);
+}
+#pragma endregion
@@ -0,0 +1,122 @@
+/**
+ * @file PCA9956_Trace.h
+ * @author マゼピン
+ * @brief PCA9956_LEDDrvが発行したI2Cトランザクションの記録と再生
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) マゼピン	2023
+ * @addtogroup pca9956
+ * @{
+ *
+ * トレースの形式(リトルエンディアン)
+ * - 先頭に "P9T1" の4バイト
+ * - 以降はレコードの繰り返し(1レコード = 7 + LEN バイト)
+ * | 位置 	| 内容 		| 説明 											|
+ * |-------|-----------|-----------------------------------------------|
+ * | 0～3 	| TIME 		| micros()の値 									|
+ * | 4 		| ADDR 		| I2Cアドレス(0xFFならフレーム区切り) 			|
+ * | 5 		| REG 		| 制御レジスタ(インクリメントフラグ込み) 		|
+ * | 6 		| LEN 		| データのバイト数 								|
+ * | 7～ 	| DATA 		| データ × LEN 									|
+ *
+ * Arduinoに依存しないので、tools/trace_replay.cpp からPC上でもビルドできる
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#pragma region 定数
+
+#define TRACE_MAGIC_SIZE 	4		//!<	先頭の "P9T1"
+#define TRACE_REC_HEADER 	7		//!<	TIME,ADDR,REG,LEN
+#define TRACE_FRAME_ADDR 	0xFF	//!<	フレーム区切りのレコードのADDR
+#define TRACE_SIM_CHIP_MAX 	8		//!<	シミュレーターで扱えるチップ数
+#define TRACE_REG_CNT 		0x40	//!<	PCA9956Bのレジスタ数(00h～3Fh)
+
+#pragma endregion
+
+#pragma region 構造体
+/// @brief トレースの1レコード
+struct T_TraceRec
+{
+	uint32_t time_us;		///<	記録した時刻(us)
+	uint8_t addr;			///<	I2Cアドレス(TRACE_FRAME_ADDRならフレーム区切り)
+	uint8_t reg;			///<	制御レジスタ
+	uint8_t len;			///<	データのバイト数
+	const uint8_t *data;	///<	データの先頭(トレースのバッファを直接指す)
+};
+
+/// @brief 2つのトレースの比較結果
+struct T_TraceDiff
+{
+	uint32_t frames[2];			///<	フレーム数
+	uint32_t transactions[2];	///<	I2Cトランザクション数
+	uint32_t bytes[2];			///<	I2Cバス上のバイト数(アドレス,制御レジスタ,データ)
+	uint32_t frame_mismatch;	///<	レジスタの状態が一致しなかったフレーム数
+	int32_t first_mismatch;		///<	最初に一致しなかったフレーム番号(-1なら全て一致)
+	bool final_match;			///<	最終状態が一致していればtrue
+	uint8_t diff_addr;			///<	最終状態で最初に違ったチップのアドレス
+	uint8_t diff_reg;			///<	最終状態で最初に違ったレジスタ
+};
+#pragma endregion 構造体
+
+/**
+ * @brief トランザクションを記録するクラス
+ * @details PCA9956_LEDDrv::set_recorder で登録すると、送信したデータを全部記録する
+ */
+class PCA9956_Recorder
+{
+private:
+#pragma region	プライベート
+	std::vector<uint8_t> _buf;		//!<	トレース
+	size_t _capacity;				//!<	記録できる最大バイト数
+	bool _overflow = false;			//!<	溢れて記録を止めたらtrue
+
+	void put32(uint32_t val);		//!<	32bit値をリトルエンディアンで追加する
+#pragma endregion
+public:
+	PCA9956_Recorder(size_t capacity);
+	~PCA9956_Recorder();
+
+	void record(uint32_t time_us, uint8_t addr, uint8_t reg, const uint8_t *data, size_t len);	//!<	トランザクションを記録する
+	void mark_frame(uint32_t time_us);							//!<	フレーム区切りを記録する
+	void clear();												//!<	記録を消す
+	const uint8_t *data();										//!<	トレースの先頭
+	size_t size();												//!<	トレースのバイト数
+	bool overflow();											//!<	溢れて記録を止めたか
+};
+
+/**
+ * @brief PCA9956Bのレジスタだけを真似るシミュレーター
+ * @details オートインクリメントの折り返しはMODE1のAI1:AI0に従う
+ */
+class PCA9956_Sim
+{
+private:
+#pragma region	プライベート
+	uint8_t _addr[TRACE_SIM_CHIP_MAX];					//!<	チップのI2Cアドレス
+	uint8_t _regs[TRACE_SIM_CHIP_MAX][TRACE_REG_CNT];	//!<	チップのレジスタ
+	uint8_t _chip_cnt = 0;								//!<	出てきたチップ数
+
+	int chip(uint8_t addr);								//!<	アドレスに対応するチップ(無ければ電源投入状態で追加)
+#pragma endregion
+public:
+	PCA9956_Sim();
+	~PCA9956_Sim();
+
+	void reset();														//!<	全チップを消す
+	void apply(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len);	//!<	トランザクションを1つ反映する
+	const uint8_t *regs(uint8_t addr);									//!<	チップのレジスタ(無ければnullptr)
+	bool equals(PCA9956_Sim &other, uint8_t *diff_addr, uint8_t *diff_reg);	//!<	2つのシミュレーターの状態を比較する
+};
+
+bool trace_next(const uint8_t *trace, size_t size, size_t *pos, T_TraceRec *rec);		//!<	トレースから次のレコードを取り出す
+bool trace_replay_frame(const uint8_t *trace, size_t size, size_t *pos, PCA9956_Sim &sim, uint32_t *tx, uint32_t *bytes);	//!<	トレースを次のフレーム区切りまで再生する
+void trace_compare(const uint8_t *a, size_t asize, const uint8_t *b, size_t bsize, T_TraceDiff &diff);	//!<	2つのトレースを再生して比較する
+
+//!	@}
@@ -14,6 +14,17 @@
 #include <Arduino.h>
 #include "PCA9956_LEDDrv.h"
 #include "testseq.h"
+#include "PCA9956_SerialIngest.h"
+#include "PCA9956_Trace.h"
+
+//	1にするとPCからシリアル経由で送られてくるフレームを表示する(tools/stream_host.py を参照)
+#define USE_SERIAL_INGEST	0
+#define INGEST_BAUD			921600	//	115200だと24ch×1チップでも300fps程度が上限
+//	1にするとtestseqのパターンを1周分記録して、"#trace"で始まる16進の行としてシリアルに出す(tools/trace_replay.cpp を参照)
+#define USE_TRACE_DUMP		0
+#define TRACE_DUMP_SIZE		(128 * 1024)	//	testseq 1周分で73kB程度
+//	1にすると起動時にディザで増えるI2Cのバイト数を測って表示する
+#define USE_DITHER_BENCH	0
 
 #if 0
 
@@ -130,11 +141,91 @@ void loop()
 static PCA9956_LEDDrv *_drv = new PCA9956_LEDDrv(0x3f);
 T_LEDOrder _order ;
 
+#if USE_SERIAL_INGEST
+
+static PCA9956_SerialIngest _ingest;
+
+void setup() {
+	Serial.setRxBufferSize(INGEST_RING_SIZE);
+	Serial.begin(INGEST_BAUD);
+	_drv->start(20);
+
+	_ingest.add_driver(_drv);	//CHIP番号0
+	_ingest.begin(&Serial);
+}
+
+/// @brief メインループ
+/// @details 受信したパケットを処理して、1秒毎に統計をテキストで返す(ホスト側は"#stat"で始まる行を拾う)<br />
+///			fpsはその1秒間の値で、それ以外は起動してからの累計
+void loop() {
+	static uint32_t last_report = 0;
+
+	_ingest.poll();
+
+	if(millis() - last_report >= 1000){
+		last_report = millis();
+		const T_IngestStats &st = _ingest.stats();
+		uint32_t fps = _ingest.fps_x100();
+		Serial.printf("#stat fps=%u.%02u frames=%u packets=%u crc=%u ovf=%u uart_ovf=%u lat=%u maxlat=%u\n"
+			, fps / 100, fps % 100, st.frames, st.packets, st.crc_errors, st.overflows, st.uart_overflows
+			, st.last_latency_us, st.max_latency_us);
+	}
+}
+
+#elif USE_TRACE_DUMP
+
+static PCA9956_Recorder *_rec = new PCA9956_Recorder(TRACE_DUMP_SIZE);
+
+void setup() {
+	Serial.begin(115200);
+	_drv->set_recorder(_rec);	//初期化から記録する
+	_drv->start(20);
+	SetPCA9956Drv(_drv);
+}
+
+/// @brief メインループ
+/// @details loop()と同じパターン(AllOff～AllOn、AllOff、FadeRGB。delayは省く)を1周記録して出力したら、あとは何もしない<br />
+///			loop()のパターンを変えた時はここと test/test_trace の記録手順も合わせる
+void loop() {
+	static bool dumped = false;
+	if(dumped){
+		return;
+	}
+
+	AllOff();
+	AllRed();
+	AllGreen();
+	AllBlue();
+	AllOff();
+	PartRGB();
+	AllOn();
+	AllOff();
+	FadeRGB();
+	_drv->set_recorder(nullptr);
+
+	const uint8_t *data = _rec->data();
+	size_t size = _rec->size();
+	for(size_t i = 0; i < size; i += 32){
+		Serial.print("#trace ");
+		for(size_t j = i; j < size && j < i + 32; j++){
+			Serial.printf("%02x", data[j]);
+		}
+		Serial.println();
+	}
+	Serial.printf("#trace-end size=%u overflow=%d\n", size, _rec->overflow());
+	dumped = true;
+}
+
+#else
+
 void setup() {
 	Serial.begin(115200);
 	_drv->start(20);		//テスト的に20mAにしているが5mAで充分明るい
 
 	SetPCA9956Drv(_drv);	//メインソースを綺麗にするために、別のソースでドライバーを制御を
+#if USE_DITHER_BENCH
+	DitherBench();
+#endif
 	AllOff();				//一旦全部LEDクリア
 
 	delay(1000);
@@ -164,7 +255,10 @@ void loop() {
 	delay(5000);
 	AllOn();
 	delay(1000);
+	AllOff();
+	FadeRGB();		//フェードエンジンで赤緑青を明るくして消す
 }
+#endif	//USE_SERIAL_INGEST,USE_TRACE_DUMP
 #endif
 
 //!	@}
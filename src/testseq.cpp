@@ -10,13 +10,28 @@
  */
 
 #include "testseq.h"
+#include "PCA9956_Dither.h"
+#include "PCA9956_Fade.h"
+#include "PCA9956_Trace.h"
+
+#define BENCH_FRAMES	256			//	ディザのベンチマークのフレーム数
+#define BENCH_TRACE		(32 * 1024)	//	ベンチマーク1回分の記録サイズ
+#define MASK_RED		0x249249	//	赤のLED(0,3,6...)
+#define MASK_GREEN		0x492492	//	緑のLED(1,4,7...)
+#define MASK_BLUE		0x924924	//	青のLED(2,5,8...)
 
 static PCA9956_LEDDrv *_drv = nullptr;
+static PCA9956_Fade *_fade = nullptr;	//	FadeRGB用のフェードエンジン(_drvに登録したもの)
 
 /// @brief 		PCA9956B用ドライバーを使えるようにする
 /// @param drv 	ドライバーオブジェクト
+/// @details 	ドライバーが変わったら、前のドライバーを登録したフェードエンジンは捨てる
 void SetPCA9956Drv(PCA9956_LEDDrv* drv)
 {
+	if(drv != _drv){
+		delete _fade;
+		_fade = nullptr;
+	}
 	_drv = drv;
 }
 
@@ -27,6 +42,7 @@ void AllOff()
 	for(int i = 0 ; i < LED_CNT; i++){
 		_drv->led_off((uint8_t)i);
 	}
+	_drv->trace_frame();
 }
 
 /// @brief 赤を徐々に明るく
@@ -43,6 +59,7 @@ void AllRed()
 			order.ledgain = gain;
 			_drv->led_pwn(order);
 		}
+		_drv->trace_frame();
 		delay(10);
 	}
 }
@@ -61,6 +78,7 @@ void AllGreen()
 			order.ledgain = gain;
 			_drv->led_pwn(order);
 		}
+		_drv->trace_frame();
 		delay(10);
 	}	
 }
@@ -79,6 +97,7 @@ void AllBlue()
 			order.ledgain = gain;
 			_drv->led_pwn(order);
 		}
+		_drv->trace_frame();
 		delay(10);
 	}	
 }
@@ -94,6 +113,7 @@ void PartRGB()
 		stdOrder.push_back(order[i]);
 	}
 	_drv->led_pwn(stdOrder);
+	_drv->trace_frame();
 }
 
 /// @brief 一気に全部フル点灯
@@ -102,4 +122,108 @@ void AllOn()
 	for(int i = 0; i < LED_CNT; i++){
 		_drv->led_on((uint8_t)i);
 	}
-}
\ No newline at end of file
+	_drv->trace_frame();
+}
+
+/// @brief フェードエンジンで赤、緑、青を少しずつずらして明るくして、最後に全部消す
+/// @details AllRed～AllBlueと同じ10ms周期だが、1tickの送信はシャドウバッファからの1回だけ
+void FadeRGB()
+{
+	if(_fade == nullptr){
+		_fade = new PCA9956_Fade(1);
+		_fade->add_driver(_drv);
+	}
+
+	_fade->submit(0, MASK_RED, LED_PWM_MAX, 256, E_FADE_CURVE::EASE_IN);
+	for(int t = 0; t <= 500 || _fade->active() > 0; t++){
+		if(t == 100){
+			_fade->submit(0, MASK_GREEN, LED_PWM_MAX, 256, E_FADE_CURVE::EASE_IN_OUT);
+		}else if(t == 200){
+			_fade->submit(0, MASK_BLUE, LED_PWM_MAX, 256, E_FADE_CURVE::EASE_OUT);
+		}else if(t == 500){
+			_fade->submit(0, MASK_RED | MASK_GREEN | MASK_BLUE, 0, 100, E_FADE_CURVE::LINEAR);
+		}
+		_fade->tick();
+		_drv->trace_frame();
+		delay(10);
+	}
+}
+
+/// @brief 			ベンチマーク用の明るさ(0-16の範囲をゆっくり上げる、LED毎に少しずらす)
+/// @param frame 	フレーム番号
+/// @param ledno 	LED番号
+/// @return 		16bitの明るさ
+static uint16_t BenchLevel(int frame, int ledno)
+{
+	return (uint16_t)(frame * 16 + ledno * 37);
+}
+
+/// @brief 			記録したトレースのバイト数とトランザクション数を表示する
+/// @param name 	表示名
+/// @param rec 		記録
+/// @param us 		掛かった時間
+static void BenchReport(const char *name, PCA9956_Recorder *rec, uint32_t us)
+{
+	static PCA9956_Sim sim;
+	size_t pos = 0;
+	uint32_t tx = 0, bytes = 0;
+
+	sim.reset();
+	while(trace_replay_frame(rec->data(), rec->size(), &pos, sim, &tx, &bytes)){
+	}
+	Serial.printf("%-22s bytes/frame=%3u.%02u tx/frame=%2u.%02u us/frame=%u%s\n", name
+		, bytes / BENCH_FRAMES, bytes * 100 / BENCH_FRAMES % 100
+		, tx / BENCH_FRAMES, tx * 100 / BENCH_FRAMES % 100
+		, us / BENCH_FRAMES, rec->overflow() ? " (overflow)" : "");
+}
+
+/// @brief ディザで増えるI2Cのバイト数を測る
+/// @details 暗い範囲のフェードを8bitのまま送った場合と、ディザを掛けた場合で比較する
+void DitherBench()
+{
+	PCA9956_Recorder *rec = new PCA9956_Recorder(BENCH_TRACE);
+	PCA9956_Dither dither(_drv);
+	uint32_t t0;
+
+	AllOff();
+
+	//8bitのまま(変わったLEDだけシャドウバッファから送る)
+	rec->clear();
+	_drv->set_recorder(rec);
+	t0 = micros();
+	for(int f = 0; f < BENCH_FRAMES; f++){
+		uint8_t *pwm = _drv->pwm_shadow();
+		for(int i = 0; i < LED_CNT; i++){
+			uint8_t v = BenchLevel(f, i) >> 8;
+			if(pwm[i] != v){
+				pwm[i] = v;
+				_drv->mark_dirty((uint8_t)i, 1);
+			}
+		}
+		_drv->flush();
+		_drv->trace_frame();
+	}
+	BenchReport("8bit", rec, micros() - t0);
+
+	//ディザ(毎回送る)、ディザ(送信範囲に合わせる)、ディザ+IREF
+	const char *name[] = {"dither", "dither bus-aware", "dither bus-aware+IREF"};
+	for(int mode = 0; mode < 3; mode++){
+		AllOff();
+		dither.set_bus_aware(mode >= 1);
+		dither.set_iref_boost(mode >= 2);
+		rec->clear();
+		t0 = micros();
+		for(int f = 0; f < BENCH_FRAMES; f++){
+			for(int i = 0; i < LED_CNT; i++){
+				dither.set16((uint8_t)i, BenchLevel(f, i));
+			}
+			dither.tick();
+			_drv->trace_frame();
+		}
+		BenchReport(name[mode], rec, micros() - t0);
+		dither.set_iref_boost(false);
+	}
+
+	_drv->set_recorder(nullptr);
+	delete rec;
+}
@@ -21,5 +21,7 @@ void AllGreen();
 void AllBlue();
 void PartRGB();
 void AllOn();
+void DitherBench();
+void FadeRGB();
 
 //!	@}
@@ -0,0 +1,69 @@
+/**
+ * @file Arduino.h
+ * @brief PC上でテストをビルドするためのArduinoの代用品
+ * @details テストで使う所だけ用意している
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <deque>
+#include <functional>
+
+typedef unsigned int uint;
+typedef uint8_t byte;
+
+#define B00			0
+#define B01			1
+#define B10			2
+#define B11			3
+#define B00000000	0x00
+#define B10000000	0x80
+#define B10100000	0xA0
+#define B11000000	0xC0
+#define B11100000	0xE0
+
+extern uint32_t g_micros;	//	micros()の値(テストから進める)
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+
+/// @brief 受信エラーの種類(ESP32のHardwareSerialと同じ)
+enum hardwareSerial_error_t
+{
+	UART_NO_ERROR,
+	UART_BREAK_ERROR,
+	UART_BUFFER_FULL_ERROR,
+	UART_FIFO_OVF_ERROR,
+	UART_FRAME_ERROR,
+	UART_PARITY_ERROR
+};
+
+/// @brief シリアルの代用品(受信データはテストからpushする)
+class HardwareSerial
+{
+public:
+	std::deque<uint8_t> rx;					//	受信データ
+	std::function<void(void)> on_receive;	//	受信コールバック
+	std::function<void(hardwareSerial_error_t)> on_receive_error;	//	受信エラーのコールバック
+
+	void begin(unsigned long baud) {}
+	void setRxBufferSize(size_t size) {}
+	void onReceive(std::function<void(void)> cb) { on_receive = cb; }
+	void onReceiveError(std::function<void(hardwareSerial_error_t)> cb) { on_receive_error = cb; }
+	int available() { return (int)rx.size(); }
+	size_t read(uint8_t *buf, size_t size);
+	int printf(const char *fmt, ...);
+	void print(const char *str) { fputs(str, stdout); }
+	void println() { fputs("\n", stdout); }
+	void println(const char *str) { puts(str); }
+
+	void push(const uint8_t *data, size_t size, bool callback);	//	受信データを追加する
+};
+
+extern HardwareSerial Serial;
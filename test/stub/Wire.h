@@ -0,0 +1,30 @@
+/**
+ * @file Wire.h
+ * @brief PC上でテストをビルドするためのWireの代用品
+ * @details 送信したデータはg_wire_logに残す
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include <vector>
+
+/// @brief 1回分の送信
+struct T_WireTx
+{
+	uint8_t addr;					//	I2Cアドレス
+	std::vector<uint8_t> bytes;		//	制御レジスタ + データ
+};
+
+extern std::vector<T_WireTx> g_wire_log;
+
+class TwoWire
+{
+public:
+	TwoWire(uint8_t bus) {}
+	bool begin(int sda, int scl, uint32_t freq) { return true; }
+	void beginTransmission(uint8_t addr) { g_wire_log.push_back({addr, {}}); }
+	size_t write(uint8_t data) { g_wire_log.back().bytes.push_back(data); return 1; }
+	size_t write(const uint8_t *data, size_t size) { for(size_t i = 0; i < size; i++) write(data[i]); return size; }
+	uint8_t endTransmission() { return 0; }
+};
@@ -0,0 +1,16 @@
+/**
+ * @file check.h
+ * @brief PC上のテスト用の簡単な確認マクロ
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+static int g_check_fail = 0;	//	失敗した数
+
+/// @brief 条件が成り立たなければ失敗として表示する
+#define CHECK(cond)	do{ if(!(cond)){ printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); g_check_fail++; } }while(0)
+
+/// @brief テストの結果を表示して終了コードを返す
+#define CHECK_RESULT()	(printf("%s: %s\n", __FILE__, g_check_fail ? "FAILED" : "OK"), g_check_fail ? 1 : 0)
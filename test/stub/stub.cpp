@@ -0,0 +1,53 @@
+/**
+ * @file stub.cpp
+ * @brief PC上でテストをビルドするためのArduinoの代用品
+ */
+
+#include "Arduino.h"
+#include "Wire.h"
+
+uint32_t g_micros = 0;
+std::vector<T_WireTx> g_wire_log;
+HardwareSerial Serial;
+
+uint32_t micros()
+{
+	return g_micros;
+}
+
+uint32_t millis()
+{
+	return g_micros / 1000;
+}
+
+void delay(uint32_t ms)
+{
+	g_micros += ms * 1000;
+}
+
+size_t HardwareSerial::read(uint8_t *buf, size_t size)
+{
+	size_t n = 0;
+	while(n < size && !rx.empty()){
+		buf[n++] = rx.front();
+		rx.pop_front();
+	}
+	return n;
+}
+
+int HardwareSerial::printf(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	int ret = vprintf(fmt, args);
+	va_end(args);
+	return ret;
+}
+
+void HardwareSerial::push(const uint8_t *data, size_t size, bool callback)
+{
+	rx.insert(rx.end(), data, data + size);
+	if(callback && on_receive){
+		on_receive();
+	}
+}
@@ -0,0 +1,202 @@
+/**
+ * @file test_main.cpp
+ * @brief PCA9956_Ditherのテスト
+ * @details 時間平均が指定した明るさになることと、IREFの切り替えで一瞬明るくならないことを確認する
+ */
+
+#include <vector>
+#include "check.h"
+#include "PCA9956_Dither.h"
+#include "PCA9956_Trace.h"
+
+#define TRACE_SIZE		(256 * 1024)
+
+/// @brief 時間平均が指定した明るさになるか
+static void test_average()
+{
+	const uint16_t values[] = {0x0180, 0x0040, 0x1234, 0x00C0, 0x08DC};
+	const int cnt = sizeof(values) / sizeof(values[0]);
+
+	for(int bus_aware = 0; bus_aware < 2; bus_aware++){
+		PCA9956_LEDDrv drv(0x3f);
+		drv.start(20);
+		PCA9956_Dither dither(&drv);
+		dither.set_bus_aware(bus_aware != 0);
+
+		uint32_t sum[cnt] = {0};
+		for(int f = 0; f < 4096; f++){
+			for(int i = 0; i < cnt; i++){
+				dither.set16((uint8_t)(i * 5), values[i]);
+			}
+			dither.tick();
+			for(int i = 0; i < cnt; i++){
+				sum[i] += drv.pwm_shadow()[i * 5];
+			}
+		}
+		for(int i = 0; i < cnt; i++){
+			//4096フレームの合計 = 明るさ × 16 (誤差は見送り分の2LSB程度)
+			int32_t diff = (int32_t)sum[i] - (int32_t)values[i] * 16;
+			CHECK(diff >= -2 && diff <= 2);
+		}
+	}
+}
+
+/// @brief IREFが通常の値の時に、PWMが低輝度側の倍率のまま残っていないか
+/// @details 送信を1つずつシミュレーターに反映して、毎回チップの状態を確認する
+static void test_iref_no_flash()
+{
+	PCA9956_Recorder rec(TRACE_SIZE);
+	PCA9956_LEDDrv drv(0x3f);
+	drv.set_recorder(&rec);
+	drv.start(20);
+	PCA9956_Dither dither(&drv);
+	uint8_t base = drv.iref_base();
+	uint16_t value[LED_CNT];
+
+	CHECK(dither.set_iref_boost(true) == E_RESULT_9956::OK);
+	for(int f = 0; f < 600; f++){
+		for(int i = 0; i < LED_CNT; i++){
+			//暗い所と明るい所を行き来させて、tick中の切り替えも通す
+			value[i] = (uint16_t)(((f + i * 25) % 300) * 40);
+			dither.set16((uint8_t)i, value[i]);
+		}
+		dither.tick();
+		drv.trace_frame();
+	}
+	dither.set_iref_boost(false);
+	drv.set_recorder(nullptr);
+	CHECK(!rec.overflow());
+
+	//最大の明るさ(前後のフレームの値)+ディザの1LSB より明るくなっていないこと
+	static PCA9956_Sim sim;
+	size_t pos = 0;
+	T_TraceRec tr;
+	int flashes = 0;
+	int iref_changes = 0;
+	while(trace_next(rec.data(), rec.size(), &pos, &tr)){
+		if(tr.addr == TRACE_FRAME_ADDR){
+			continue;
+		}
+		sim.apply(tr.addr, tr.reg, tr.data, tr.len);
+		if((tr.reg & 0x7F) >= 0x22 && tr.len < LED_CNT){	//startの全LED分は除く
+			iref_changes++;
+		}
+		const uint8_t *r = sim.regs(tr.addr);
+		for(int i = 0; i < LED_CNT; i++){
+			if(r[0x22 + i] == base && r[0x0A + i] > (300 * 40 >> 8) + 2){
+				flashes++;
+			}
+		}
+	}
+	CHECK(iref_changes > LED_CNT);		//範囲の切り替えが起きている
+	CHECK(flashes == 0);
+}
+
+/// @brief 低輝度側のLEDがある状態でIREFの切り替えを止めた時に一瞬明るくならないか
+static void test_boost_off()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	drv.start(20);
+	PCA9956_Dither dither(&drv);
+	dither.set_iref_boost(true);
+	dither.set16(0, 0x08DC);	//8.86LSB
+	for(int f = 0; f < 10; f++){
+		dither.tick();
+	}
+	CHECK(drv.pwm_shadow()[0] > 100);		//低輝度側の倍率が掛かっている
+
+	g_wire_log.clear();
+	dither.set_iref_boost(false);
+
+	//PWMを戻してからIREFを上げる
+	int pwm_at = -1, iref_at = -1;
+	for(size_t i = 0; i < g_wire_log.size(); i++){
+		uint8_t reg = g_wire_log[i].bytes[0] & 0x7F;
+		if(reg <= 0x0A && reg + g_wire_log[i].bytes.size() - 1 > 0x0A){
+			pwm_at = (int)i;
+			CHECK(g_wire_log[i].bytes[0x0A - reg + 1] == 0x08);
+		}
+		if(reg == 0x22){
+			iref_at = (int)i;
+			CHECK(g_wire_log[i].bytes[1] == drv.iref_base());
+		}
+	}
+	CHECK(pwm_at >= 0 && iref_at > pwm_at);
+}
+
+/// @brief 範囲外のLED番号でIREF以外のレジスタに書かないか
+static void test_iref_range()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	size_t txcnt = g_wire_log.size();
+
+	CHECK(drv.led_iref(LED_CNT, 0x10) == E_RESULT_9956::NG);
+	CHECK(drv.led_iref(0xFF, 0x10) == E_RESULT_9956::NG);
+	CHECK(g_wire_log.size() == txcnt);
+}
+
+/// @brief 12bitの範囲を超えた値は最大の明るさになるか
+static void test_set12_clamp()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	drv.start(20);
+	PCA9956_Dither dither(&drv);
+
+	dither.set12(0, 4095);
+	dither.set12(1, 4096);
+	dither.set12(2, 0xFFFF);
+	dither.tick();
+	CHECK(drv.pwm_shadow()[0] == LED_PWM_MAX);
+	CHECK(drv.pwm_shadow()[1] == LED_PWM_MAX);
+	CHECK(drv.pwm_shadow()[2] == LED_PWM_MAX);
+}
+
+/// @brief 同じフレームで範囲を切り替えるLEDのIREFをまとめて送るか
+static void test_iref_burst()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	drv.start(20);
+	PCA9956_Dither dither(&drv);
+	dither.set_iref_boost(true);
+	for(int i = 0; i < LED_CNT; i++){
+		dither.set16((uint8_t)i, (i == 12) ? 0xFFFF : 0x0100);	//LED12以外を低輝度側にする
+	}
+
+	g_wire_log.clear();
+	dither.tick();
+	int iref_tx = 0, pwm_at = -1, iref_at = -1;
+	for(size_t i = 0; i < g_wire_log.size(); i++){
+		uint8_t reg = g_wire_log[i].bytes[0] & 0x7F;
+		if(reg >= 0x22){
+			iref_tx++;
+			iref_at = (int)i;
+		}else if(pwm_at < 0 && reg >= 0x0A){
+			pwm_at = (int)i;
+		}
+	}
+	CHECK(iref_tx == 2);				//LED0-11とLED13-23
+	CHECK(iref_at >= 0 && iref_at < pwm_at);	//PWMより先に下げる
+
+	//まとめて通常側に戻す時はPWMの後に上げる
+	for(int i = 0; i < LED_CNT; i++){
+		dither.set16((uint8_t)i, 0xFFFF);
+	}
+	g_wire_log.clear();
+	dither.tick();
+	CHECK(g_wire_log.size() == 3);		//PWM、IREF0-11、IREF13-23
+	CHECK((g_wire_log[0].bytes[0] & 0x7F) < 0x22);
+	CHECK(g_wire_log[1].bytes.size() == 1 + 12 && g_wire_log[2].bytes.size() == 1 + 11);
+	CHECK(g_wire_log[1].bytes[1] == drv.iref_base());
+}
+
+int main()
+{
+	test_average();
+	test_iref_no_flash();
+	test_boost_off();
+	test_iref_range();
+	test_set12_clamp();
+	test_iref_burst();
+
+	return CHECK_RESULT();
+}
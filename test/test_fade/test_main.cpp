@@ -0,0 +1,115 @@
+/**
+ * @file test_main.cpp
+ * @brief PCA9956_Fadeのテスト
+ * @details 指定したtick数ちょうどで目標の明るさに届くことを確認する
+ */
+
+#include "check.h"
+#include "PCA9956_Fade.h"
+#include "testseq.h"
+
+/// @brief 何tick目で終わったか
+/// @return 動作中のフェードが無くなったtick数
+static uint32_t run(PCA9956_Fade &fade, uint32_t limit)
+{
+	uint32_t t = 0;
+	while(fade.active() > 0 && t < limit){
+		fade.tick();
+		t++;
+	}
+	return t;
+}
+
+/// @brief 長さの違うフェードがちょうどticksで終わるか
+static void test_exact_ticks()
+{
+	const uint32_t ticks[] = {1, 2, 3, 7, 255, 4096, 4097, 12345, 100000, 1000003};
+
+	for(uint32_t n : ticks){
+		PCA9956_LEDDrv drv(0x3f);
+		PCA9956_Fade fade(1);
+		fade.add_driver(&drv);
+		CHECK(fade.submit(0, 0x000001, 200, n, E_FADE_CURVE::LINEAR) == E_RESULT_9956::OK);
+
+		uint32_t t = 0;
+		uint8_t last = 0;
+		bool monotonic = true;
+		while(fade.active() > 0 && t < n + 10){
+			fade.tick();
+			t++;
+			if(drv.pwm_shadow()[0] < last){
+				monotonic = false;
+			}
+			last = drv.pwm_shadow()[0];
+			if(t == n / 2 && n >= 100){
+				CHECK(last >= 99 && last <= 101);	//半分で半分の明るさ
+			}
+			if(t < n){
+				CHECK(fade.active() == 1);
+			}
+		}
+		CHECK(t == n);
+		CHECK(last == 200);
+		CHECK(monotonic);
+	}
+}
+
+/// @brief チップとLEDが違っても、同時に始めたフェードは同じtickで終わるか
+static void test_multi()
+{
+	PCA9956_LEDDrv drv0(0x3f), drv1(0x3e);
+	PCA9956_Fade fade(2);
+	fade.add_driver(&drv0);
+	fade.add_driver(&drv1);
+
+	fade.submit(0, 0xFFFFFF, 255, 1000, E_FADE_CURVE::EASE_IN_OUT);
+	fade.submit(1, 0x00FF00, 128, 1000, E_FADE_CURVE::EASE_OUT);
+	CHECK(fade.active() == LED_CNT + 8);
+	CHECK(run(fade, 2000) == 1000);
+	for(int i = 0; i < LED_CNT; i++){
+		CHECK(drv0.pwm_shadow()[i] == 255);
+		CHECK(drv1.pwm_shadow()[i] == ((0x00FF00 >> i) & 1 ? 128 : 0));
+	}
+
+	//0tickならすぐ目標の明るさ
+	fade.submit(0, 0x000003, 10, 0, E_FADE_CURVE::LINEAR);
+	CHECK(fade.active() == 0);
+	CHECK(drv0.pwm_shadow()[0] == 10 && drv0.pwm_shadow()[1] == 10);
+}
+
+/// @brief FadeRGBのドライバーを変えたら、新しいドライバーに送信するか
+static void test_fadergb_rebind()
+{
+	PCA9956_LEDDrv drvs[2] = {PCA9956_LEDDrv(0x30), PCA9956_LEDDrv(0x31)};
+
+	for(int n = 0; n < 2; n++){
+		PCA9956_LEDDrv &drv = drvs[n];
+		uint8_t addr = 0x30 + n;
+		drv.start(20);
+		SetPCA9956Drv(&drv);
+		g_wire_log.clear();
+		FadeRGB();
+
+		size_t pwm_tx = 0;
+		for(auto &tx : g_wire_log){
+			CHECK(tx.addr == addr);
+			if((tx.bytes[0] & 0x7F) >= 0x0A && (tx.bytes[0] & 0x7F) < 0x0A + LED_CNT){
+				pwm_tx++;
+			}
+		}
+		CHECK(pwm_tx > 300);
+		for(int i = 0; i < LED_CNT; i++){
+			CHECK(drv.pwm_shadow()[i] == 0);	//最後は全部消える
+		}
+	}
+	SetPCA9956Drv(nullptr);
+}
+
+int main()
+{
+	test_exact_ticks();
+	test_multi();
+	test_fadergb_rebind();
+
+	return CHECK_RESULT();
+}
@@ -0,0 +1,281 @@
+/**
+ * @file test_main.cpp
+ * @brief PCA9956_SerialIngestのテスト
+ * @details 細切れの受信、ゴミデータ、CRCエラー、リングの折り返しでも
+ *			送ったフレームがそのままシャドウバッファとI2Cに出ることを確認する
+ */
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include "check.h"
+#include "PCA9956_SerialIngest.h"
+
+/// @brief CRC-8(多項式0x07,初期値0x00)
+static uint8_t crc8(const uint8_t *data, size_t size)
+{
+	uint8_t crc = 0;
+	for(size_t i = 0; i < size; i++){
+		crc ^= data[i];
+		for(int bit = 0; bit < 8; bit++){
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+/// @brief パケットを作って追加する(valuesが空ならフレーム終端マーカー)
+static void packet(std::vector<uint8_t> &out, uint8_t chip, uint8_t start, const std::vector<uint8_t> &values)
+{
+	size_t top = out.size();
+	out.push_back(INGEST_SYNC);
+	out.push_back(chip);
+	out.push_back(start);
+	out.push_back((uint8_t)values.size());
+	out.insert(out.end(), values.begin(), values.end());
+	out.push_back(crc8(&out[top + 1], out.size() - top - 1));
+}
+
+/// @brief 細切れに受信したランダムなフレームがそのまま出るか
+static void test_random_frames()
+{
+	PCA9956_LEDDrv drv0(0x3f), drv1(0x3e);
+	PCA9956_SerialIngest ingest;
+	ingest.add_driver(&drv0);
+	ingest.add_driver(&drv1);
+	PCA9956_LEDDrv *drv[2] = {&drv0, &drv1};
+	uint8_t expect[2][LED_CNT] = {{0}};
+	uint32_t crc_errors = 0;
+
+	srand(1234);
+	for(int f = 0; f < 2000; f++){
+		std::vector<uint8_t> stream;
+
+		//フレームの前にゴミ(SYNC以外)
+		int junk = rand() % 4;
+		for(int i = 0; i < junk; i++){
+			stream.push_back((uint8_t)(rand() % 0xA5));
+		}
+
+		int pkts = 1 + rand() % 3;
+		for(int p = 0; p < pkts; p++){
+			uint8_t chip = rand() % 2;
+			uint8_t start = rand() % LED_CNT;
+			uint8_t len = 1 + rand() % (LED_CNT - start);
+			std::vector<uint8_t> values;
+			for(int i = 0; i < len; i++){
+				values.push_back((uint8_t)rand());
+			}
+			packet(stream, chip, start, values);
+			if(rand() % 50 == 0){
+				stream.back() ^= 0x5A;		//CRCを壊す(このパケットは捨てられる)
+				crc_errors++;
+			}else{
+				memcpy(&expect[chip][start], values.data(), len);
+			}
+		}
+		packet(stream, 0, 0, {});
+
+		//1～64バイトずつ受信する
+		for(size_t pos = 0; pos < stream.size(); ){
+			size_t chunk = 1 + rand() % 64;
+			if(chunk > stream.size() - pos){
+				chunk = stream.size() - pos;
+			}
+			CHECK(ingest.feed(&stream[pos], chunk) == chunk);
+			ingest.poll();
+			pos += chunk;
+		}
+
+		for(int c = 0; c < 2; c++){
+			CHECK(memcmp(drv[c]->pwm_shadow(), expect[c], LED_CNT) == 0);
+			uint8_t lo, hi;
+			CHECK(!drv[c]->dirty_range(lo, hi));	//フレーム終端で全部送っている
+		}
+	}
+
+	CHECK(ingest.stats().frames == 2000);
+	CHECK(ingest.stats().crc_errors == crc_errors);
+	CHECK(ingest.stats().overflows == 0);
+
+	//I2Cに出た最後の値もシャドウバッファと同じ
+	uint8_t chip_state[2][LED_CNT] = {{0}};
+	for(auto &tx : g_wire_log){
+		int c = (tx.addr == 0x3f) ? 0 : 1;
+		uint8_t reg = tx.bytes[0] & 0x7F;
+		for(size_t i = 1; i < tx.bytes.size(); i++){
+			if(reg + i - 1 >= 0x0A && reg + i - 1 < 0x0A + LED_CNT){
+				chip_state[c][reg + i - 1 - 0x0A] = tx.bytes[i];
+			}
+		}
+	}
+	CHECK(memcmp(chip_state[0], expect[0], LED_CNT) == 0);
+	CHECK(memcmp(chip_state[1], expect[1], LED_CNT) == 0);
+}
+
+/// @brief パケットの区切りと受信の区切りがずれていても遅延が正しく出るか
+/// @details 34バイトのフレームを1msおきに40バイトずつ受信する
+static void test_latency()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	PCA9956_SerialIngest ingest;
+	ingest.add_driver(&drv);
+
+	std::vector<uint8_t> stream;
+	for(int f = 0; f < 200; f++){
+		packet(stream, 0, 0, std::vector<uint8_t>(LED_CNT, (uint8_t)f));
+		packet(stream, 0, 0, {});
+	}
+
+	for(size_t pos = 0; pos < stream.size(); pos += 40){
+		g_micros += 1000;
+		ingest.feed(&stream[pos], (stream.size() - pos < 40) ? stream.size() - pos : 40);
+		ingest.poll();
+	}
+
+	CHECK(ingest.stats().frames == 200);
+	CHECK(ingest.stats().max_latency_us <= 1000);
+}
+
+/// @brief 前回からのフレームレートになっているか
+static void test_fps()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	PCA9956_SerialIngest ingest;
+	ingest.add_driver(&drv);
+	std::vector<uint8_t> frame;
+	packet(frame, 0, 0, {1, 2, 3});
+	packet(frame, 0, 0, {});
+
+	g_micros += 5000000;	//しばらく何も来ない
+	ingest.fps_x100();
+
+	for(int i = 0; i < 100; i++){
+		g_micros += 10000;
+		ingest.feed(frame.data(), frame.size());
+		ingest.poll();
+	}
+	CHECK(ingest.fps_x100() == 10000);	//100fps
+
+	g_micros += 1000000;
+	CHECK(ingest.fps_x100() == 0);
+}
+
+/// @brief リングが一杯でUARTに残ったデータもpollで読み込むか
+static void test_serial_backlog()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	PCA9956_SerialIngest ingest;
+	ingest.add_driver(&drv);
+	HardwareSerial serial;
+	ingest.begin(&serial);
+
+	std::vector<uint8_t> stream;
+	int frames = INGEST_RING_SIZE / 34 + 4;		//リングに入りきらない量
+	for(int f = 0; f < frames; f++){
+		packet(stream, 0, 0, std::vector<uint8_t>(LED_CNT, (uint8_t)f));
+		packet(stream, 0, 0, {});
+	}
+	serial.push(stream.data(), stream.size(), true);	//受信コールバックは1回だけ
+	CHECK(serial.available() > 0);
+
+	for(int i = 0; i < 4; i++){
+		ingest.poll();
+	}
+	CHECK(serial.available() == 0);
+	CHECK(ingest.stats().frames == (uint32_t)frames);
+	CHECK(drv.pwm_shadow()[0] == (uint8_t)(frames - 1));
+	CHECK(ingest.stats().overflows == 0);		//リングが一杯の間はUART側に残している
+
+	//UART側で溢れた回数を数える(溢れ以外のエラーは数えない)
+	CHECK(serial.on_receive_error != nullptr);
+	serial.on_receive_error(UART_FIFO_OVF_ERROR);
+	serial.on_receive_error(UART_BUFFER_FULL_ERROR);
+	serial.on_receive_error(UART_FRAME_ERROR);
+	CHECK(ingest.stats().uart_overflows == 2);
+}
+
+/// @brief 疑似端末を通して受信したフレームがそのまま出るか
+/// @details 片側に書き込んで、もう片側からreadした単位でfeedする(受信の区切りはOS任せ)
+static void test_pty()
+{
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	CHECK(master >= 0);
+	if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0){
+		return;
+	}
+	int slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+	CHECK(slave >= 0);
+	struct termios tio;
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+	tcgetattr(master, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(master, TCSANOW, &tio);
+
+	PCA9956_LEDDrv drv(0x3f);
+	PCA9956_SerialIngest ingest;
+	ingest.add_driver(&drv);
+
+	const int frames = 500;
+	uint8_t buf[256];
+	for(int f = 0; f < frames; f++){
+		std::vector<uint8_t> stream;
+		std::vector<uint8_t> values;
+		for(int i = 0; i < LED_CNT; i++){
+			values.push_back((uint8_t)(f + i * 10));
+		}
+		packet(stream, 0, 0, values);
+		packet(stream, 0, 0, {});
+		CHECK(write(master, stream.data(), stream.size()) == (ssize_t)stream.size());
+
+		for(int retry = 0; retry < 1000 && ingest.stats().frames <= (uint32_t)f; retry++){
+			ssize_t n = read(slave, buf, sizeof(buf));
+			if(n > 0){
+				ingest.feed(buf, n);
+				ingest.poll();
+			}else{
+				usleep(100);
+			}
+		}
+		CHECK(memcmp(drv.pwm_shadow(), values.data(), LED_CNT) == 0);
+	}
+	CHECK(ingest.stats().frames == (uint32_t)frames);
+
+	close(slave);
+	close(master);
+}
+
+/// @brief 範囲外のLED番号でシャドウバッファの外に書かないか
+static void test_led_range()
+{
+	PCA9956_LEDDrv drv(0x3f);
+	T_LEDOrder order = {LED_CNT, 100};
+	size_t txcnt = g_wire_log.size();
+
+	CHECK(drv.led_pwn(order) == E_RESULT_9956::NG);
+	CHECK(g_wire_log.size() == txcnt);
+	uint8_t lo, hi;
+	CHECK(!drv.dirty_range(lo, hi));
+
+	//末尾を超える個数は最後のLEDまでにする
+	drv.mark_dirty(10, 250);
+	CHECK(drv.dirty_range(lo, hi));
+	CHECK(lo == 10);
+	CHECK(hi == LED_CNT);
+}
+
+int main()
+{
+	test_random_frames();
+	test_latency();
+	test_fps();
+	test_serial_backlog();
+	test_pty();
+	test_led_range();
+
+	return CHECK_RESULT();
+}
@@ -0,0 +1,102 @@
+/**
+ * @file test_main.cpp
+ * @brief testseqのパターンのトレースを正解(golden_testseq.trace)と比較するテスト
+ * @details main.cppのUSE_TRACE_DUMPと同じ手順で1周分記録して、フレーム毎のレジスタの状態を比較する<br />
+ *			ドライバーを意図して変更した時は make -C test golden で正解を作り直す
+ */
+
+#include <stdlib.h>
+#include <vector>
+#include "check.h"
+#include "PCA9956_Trace.h"
+#include "testseq.h"
+
+#define GOLDEN_FILE		"golden_testseq.trace"
+#define TRACE_SIZE		(128 * 1024)
+
+/// @brief testseqのパターンを1周記録する
+static void record(PCA9956_Recorder &rec)
+{
+	PCA9956_LEDDrv drv(0x3f);
+
+	drv.set_recorder(&rec);
+	drv.start(20);
+	SetPCA9956Drv(&drv);
+	AllOff();
+	AllRed();
+	AllGreen();
+	AllBlue();
+	AllOff();
+	PartRGB();
+	AllOn();
+	AllOff();
+	FadeRGB();
+	drv.set_recorder(nullptr);
+	SetPCA9956Drv(nullptr);
+}
+
+/// @brief 正解のトレースを読み込む
+static bool load(std::vector<uint8_t> &out)
+{
+	FILE *fp = fopen(GOLDEN_FILE, "rb");
+	if(fp == nullptr){
+		return false;
+	}
+	uint8_t buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), fp)) > 0){
+		out.insert(out.end(), buf, buf + n);
+	}
+	fclose(fp);
+	return true;
+}
+
+int main()
+{
+	PCA9956_Recorder rec(TRACE_SIZE);
+	record(rec);
+	CHECK(!rec.overflow());
+
+	if(getenv("UPDATE_GOLDEN") != nullptr){
+		FILE *fp = fopen(GOLDEN_FILE, "wb");
+		CHECK(fp != nullptr);
+		if(fp != nullptr){
+			fwrite(rec.data(), 1, rec.size(), fp);
+			fclose(fp);
+			printf("%s: %u bytes written\n", GOLDEN_FILE, (unsigned)rec.size());
+		}
+		return CHECK_RESULT();
+	}
+
+	std::vector<uint8_t> golden;
+	CHECK(load(golden));
+
+	T_TraceDiff diff;
+	trace_compare(golden.data(), golden.size(), rec.data(), rec.size(), diff);
+	printf("frames=%u/%u transactions=%u/%u bytes=%u/%u mismatch=%u first=%d\n"
+		, diff.frames[0], diff.frames[1], diff.transactions[0], diff.transactions[1]
+		, diff.bytes[0], diff.bytes[1], diff.frame_mismatch, (int)diff.first_mismatch);
+	CHECK(diff.frames[0] > 0);
+	CHECK(diff.frames[0] == diff.frames[1]);
+	CHECK(diff.frame_mismatch == 0);
+	CHECK(diff.final_match);
+
+	//比較側が違いを見つけられること(PWMの値を1つ変えたトレース)
+	std::vector<uint8_t> broken(rec.data(), rec.data() + rec.size());
+	size_t pos = 0;
+	T_TraceRec tr;
+	uint32_t frame = 0;
+	while(trace_next(broken.data(), broken.size(), &pos, &tr)){
+		if(tr.addr == TRACE_FRAME_ADDR){
+			frame++;
+		}else if(frame == diff.frames[0] / 2 && (tr.reg & 0x7F) >= 0x0A && tr.len > 0){
+			broken[tr.data - broken.data()] ^= 0x01;
+			break;
+		}
+	}
+	trace_compare(golden.data(), golden.size(), broken.data(), broken.size(), diff);
+	CHECK(diff.frame_mismatch > 0);
+	CHECK(diff.first_mismatch == (int32_t)frame);
+
+	return CHECK_RESULT();
+}
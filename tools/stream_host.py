@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""PCA9956_SerialIngest 用のホスト側送信ツール
+
+パケットの形式は src/PCA9956_SerialIngest.h を参照
+
+使い方
+    python3 tools/stream_host.py /dev/ttyUSB0 --baud 921600 --fps 100 --seconds 10
+        グラデーションを流して、ESP32から返ってくる "#stat" 行を表示する
+    python3 tools/stream_host.py --pty
+        疑似端末の片側に送信して、もう片側で受信したパケットを解析して照合する
+        (実機無しで送信側のフレーミングと送信速度を確認する)
+        ESP32側の受信処理(PCA9956_SerialIngest)は make -C test でPC上でテストする
+
+pyserial は使わず termios だけで動くようにしている
+"""
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+import tty
+
+SYNC = 0xA5
+LED_CNT = 24
+
+BAUDS = {
+    115200: termios.B115200,
+    230400: termios.B230400,
+    460800: getattr(termios, "B460800", None),
+    921600: getattr(termios, "B921600", None),
+}
+
+
+def crc8(data):
+    """CRC-8(多項式0x07,初期値0x00)"""
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def packet(chip, start, values):
+    """PWM値のパケットを作る(valuesが空ならフレーム終端マーカー)"""
+    body = bytes([chip, start, len(values)]) + bytes(values)
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+def frame(chips):
+    """chips = [[PWM値×24], ...] から1フレーム分のバイト列を作る"""
+    out = b"".join(packet(i, 0, v) for i, v in enumerate(chips))
+    return out + packet(0, 0, [])
+
+
+def parse(buf):
+    """受信側と同じ手順でパケットを取り出す(疑似端末での照合用)
+    戻り値: (フレームのリスト, 残りのバイト列)"""
+    frames, cur = [], {}
+    i = 0
+    while True:
+        while i < len(buf) and buf[i] != SYNC:
+            i += 1
+        if len(buf) - i < 5:
+            break
+        chip, start, n = buf[i + 1], buf[i + 2], buf[i + 3]
+        if n > 0 and (start >= LED_CNT or n > LED_CNT - start):
+            i += 1
+            continue
+        if len(buf) - i < 5 + n:
+            break
+        if crc8(buf[i + 1:i + 4 + n]) != buf[i + 4 + n]:
+            i += 1
+            continue
+        if n == 0:
+            frames.append(cur)
+            cur = {}
+        else:
+            cur.setdefault(chip, [0] * LED_CNT)[start:start + n] = buf[i + 4:i + 4 + n]
+        i += 5 + n
+    return frames, buf[i:]
+
+
+def gradient(t, chips):
+    return [[(t + ch * 10 + c * 3) & 0xFF for ch in range(LED_CNT)] for c in range(chips)]
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    speed = BAUDS.get(baud)
+    if speed is not None:
+        attr = termios.tcgetattr(fd)
+        attr[4] = attr[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attr)
+    return fd
+
+
+def run_device(args):
+    fd = open_port(args.port, args.baud)
+    period = 1.0 / args.fps if args.fps else 0.0
+    sent = nbytes = 0
+    rx = b""
+    t0 = time.monotonic()
+    while time.monotonic() - t0 < args.seconds:
+        data = frame(gradient(sent, args.chips))
+        os.write(fd, data)
+        sent += 1
+        nbytes += len(data)
+        r, _, _ = select.select([fd], [], [], 0)
+        if r:
+            rx += os.read(fd, 4096)
+            *lines, rx = rx.split(b"\n")
+            for line in lines:
+                if line.startswith(b"#stat"):
+                    print(line.decode(errors="replace"))
+        if period:
+            time.sleep(max(0.0, t0 + sent * period - time.monotonic()))
+    dt = time.monotonic() - t0
+    print("host: %d frames %.1f fps %.1f kB/s" % (sent, sent / dt, nbytes / dt / 1000))
+    os.close(fd)
+
+
+def run_pty(args):
+    master, slave = os.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    expect = [gradient(t, args.chips) for t in range(args.frames)]
+    got, rx = [], b""
+    t0 = time.monotonic()
+    for chips in expect:
+        os.write(master, frame(chips))
+        while select.select([slave], [], [], 0)[0]:
+            rx += os.read(slave, 4096)
+            fr, rx = parse(rx)
+            got += fr
+    while len(got) < len(expect) and select.select([slave], [], [], 1.0)[0]:
+        rx += os.read(slave, 4096)
+        fr, rx = parse(rx)
+        got += fr
+    dt = time.monotonic() - t0
+    os.close(master)
+    os.close(slave)
+
+    ok = len(got) == len(expect) and all(
+        [g.get(c) for c in range(args.chips)] == [list(v) for v in e] for g, e in zip(got, expect))
+    print("pty: %d/%d frames %s, %.0f fps through the pty" %
+          (len(got), len(expect), "OK" if ok else "MISMATCH", len(got) / dt))
+    return 0 if ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?", help="シリアルポート(/dev/ttyUSB0 など)")
+    ap.add_argument("--baud", type=int, default=921600)
+    ap.add_argument("--chips", type=int, default=1, help="ドライバーの数(CHIP番号0～)")
+    ap.add_argument("--fps", type=float, default=0, help="送信フレームレート(0なら全速)")
+    ap.add_argument("--seconds", type=float, default=10)
+    ap.add_argument("--pty", action="store_true", help="疑似端末で送受信を照合する")
+    ap.add_argument("--frames", type=int, default=1000, help="--pty で送るフレーム数")
+    args = ap.parse_args()
+
+    if args.pty:
+        return run_pty(args)
+    if not args.port:
+        ap.error("port か --pty を指定してください")
+    run_device(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,142 @@
+/**
+ * @file trace_replay.cpp
+ * @author マゼピン
+ * @brief PCA9956_Recorderで記録したトレースをPC上で再生して比較するツール
+ * @details ライセンスはMITライセンスです
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * ビルド
+ *		g++ -std=c++11 -O2 -Isrc tools/trace_replay.cpp src/PCA9956_Trace.cpp -o trace_replay
+ *
+ * 使い方
+ *		trace_replay before.trace					1つなら再生して最終状態を表示する
+ *		trace_replay before.trace after.trace		2つならフレーム毎の状態とバイト数を比較する(一致しなければ終了コード1)
+ *
+ * トレースはバイナリ("P9T1"で始まる)と、USE_TRACE_DUMPでシリアルに出した"#trace"の行を保存したテキストのどちらでも良い
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "PCA9956_Trace.h"
+
+/// @brief 		トレースを読み込む
+/// @param path ファイル名
+/// @param out 	トレース
+/// @return 	読めたらtrue
+static bool load(const char *path, std::vector<uint8_t> &out)
+{
+	FILE *fp = fopen(path, "rb");
+	if(fp == nullptr){
+		fprintf(stderr, "%s: open failed\n", path);
+		return false;
+	}
+	std::vector<uint8_t> raw;
+	uint8_t buf[4096];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), fp)) > 0){
+		raw.insert(raw.end(), buf, buf + n);
+	}
+	fclose(fp);
+
+	if(raw.size() >= 4 && memcmp(raw.data(), "P9T1", 4) == 0){
+		out = raw;
+		return true;
+	}
+
+	//シリアルログから"#trace "の行だけ拾う
+	raw.push_back('\0');
+	const char *line = (const char *)raw.data();
+	while(line != nullptr && *line != '\0'){
+		const char *p = strstr(line, "#trace ");
+		if(p == nullptr){
+			break;
+		}
+		p += 7;
+		while(p[0] != '\0' && p[1] != '\0' && strchr("0123456789abcdefABCDEF", p[0]) && strchr("0123456789abcdefABCDEF", p[1])){
+			char hex[3] = {p[0], p[1], '\0'};
+			out.push_back((uint8_t)strtoul(hex, nullptr, 16));
+			p += 2;
+		}
+		line = strchr(p, '\n');
+	}
+	if(out.size() < 4 || memcmp(out.data(), "P9T1", 4) != 0){
+		fprintf(stderr, "%s: not a trace\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+/// @brief 		1つのトレースを再生して最終状態を表示する
+/// @param tr 	トレース
+static void show(std::vector<uint8_t> &tr)
+{
+	static PCA9956_Sim sim;
+	size_t pos = 0;
+	uint32_t frames = 0, tx = 0, bytes = 0;
+
+	while(trace_replay_frame(tr.data(), tr.size(), &pos, sim, &tx, &bytes)){
+		frames++;
+	}
+	printf("frames=%u transactions=%u bytes=%u\n", frames, tx, bytes);
+
+	for(int addr = 0; addr < 0x80; addr++){
+		const uint8_t *r = sim.regs((uint8_t)addr);
+		if(r == nullptr){
+			continue;
+		}
+		printf("chip 0x%02x MODE1=%02x MODE2=%02x\n  PWM ", addr, r[0x00], r[0x01]);
+		for(int i = 0; i < 24; i++){
+			printf("%02x ", r[0x0A + i]);
+		}
+		printf("\n  IREF");
+		for(int i = 0; i < 24; i++){
+			printf(" %02x", r[0x22 + i]);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 2 || argc > 3){
+		fprintf(stderr, "usage: %s a.trace [b.trace]\n", argv[0]);
+		return 2;
+	}
+
+	std::vector<uint8_t> tr[2];
+	for(int i = 1; i < argc; i++){
+		if(!load(argv[i], tr[i - 1])){
+			return 2;
+		}
+	}
+	if(argc == 2){
+		show(tr[0]);
+		return 0;
+	}
+
+	T_TraceDiff diff;
+	trace_compare(tr[0].data(), tr[0].size(), tr[1].data(), tr[1].size(), diff);
+
+	printf("%-13s %12s %12s %8s\n", "", "A", "B", "B-A");
+	printf("%-13s %12u %12u %+8d\n", "frames", diff.frames[0], diff.frames[1], (int)(diff.frames[1] - diff.frames[0]));
+	printf("%-13s %12u %12u %+8d\n", "transactions", diff.transactions[0], diff.transactions[1], (int)(diff.transactions[1] - diff.transactions[0]));
+	printf("%-13s %12u %12u %+8d\n", "bytes", diff.bytes[0], diff.bytes[1], (int)(diff.bytes[1] - diff.bytes[0]));
+	printf("frame mismatch=%u", diff.frame_mismatch);
+	if(diff.first_mismatch >= 0){
+		printf(" (first at frame %d)", diff.first_mismatch);
+	}
+	printf("\n");
+	if(diff.final_match){
+		printf("final state: match\n");
+	}else{
+		printf("final state: differ (chip 0x%02x reg 0x%02x)\n", diff.diff_addr, diff.diff_reg);
+	}
+
+	return (diff.final_match && diff.frame_mismatch == 0) ? 0 : 1;
+}